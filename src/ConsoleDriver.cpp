@@ -1,10 +1,13 @@
 #include <cstdio>
 #include <chrono>
+#include <thread>
 #include <cmath>
+#include <ctime>
 #include <assert.h>
 #include "ConsoleDriver.h"
 #include "controller/PretimedController.h"
 #include "controller/BasicController.h"
+#include "controller/MaxPressureController.h"
 
 using namespace std;
 
@@ -12,41 +15,47 @@ using namespace std;
  * Initializes a new ConsoleDriver.
  * @param iterationsPerSecond the number of iterations to be executed in the simulator per second
  * @param file the file to load the city
- * @param controllerType 0 if PretimedController, 1 for BasicController
+ * @param controllerType 0 if PretimedController, 1 for BasicController, 2 for MaxPressureController
  */
 ConsoleDriver::ConsoleDriver(double iterationsPerSecond, string file, int controllerType) {
     assert(iterationsPerSecond > 0.0 && "iterationsPerSecond must be a positive value");
     this->iterationsPerSecond = iterationsPerSecond;
     iterationLength = 1.0 / iterationsPerSecond;
-    freopen(file.c_str(), "r", stdin);
-    G = new WeightedDigraph();
+    FILE *in = fopen(file.c_str(), "r");
+    assert(in != nullptr && "unable to open file");
+    context = new SimulationContext();
+    G = context->getGraph();
+    G->setSeed(time(0)); // every run is different
     if (controllerType == 0) controller = new PretimedController(G);
     else if (controllerType == 1) controller = new BasicController(G);
+    else if (controllerType == 2) controller = new MaxPressureController(G);
     sim = new Simulation(controller);
+    G->setPool(sim->getPool());
     int cntIntersections;
     int cntRoadSegments;
     int cntCars;
-    scanf("%d %d %d %d", &cntIntersections, &cntRoadSegments, &cntCars, &carsPerSecond);
+    fscanf(in, "%d %d %d %d", &cntIntersections, &cntRoadSegments, &cntCars, &carsPerSecond);
     Intersection *intersections[cntIntersections];
     for (int i = 0; i < cntIntersections; i++) {
         double x;
         double y;
-        scanf("%lf %lf", &x, &y);
-        intersections[i] = new Intersection(x, y);
+        fscanf(in, "%lf %lf", &x, &y);
+        intersections[i] = new Intersection(context, x, y);
     }
     for (int i = 0; i < cntRoadSegments; i++) {
         int A;
         int B;
         double speedLimit;
         int capacity;
-        scanf("%d %d %lf %d", &A, &B, &speedLimit, &capacity);
+        fscanf(in, "%d %d %lf %d", &A, &B, &speedLimit, &capacity);
         assert(G->addRoadSegment(new RoadSegment(intersections[A], intersections[B], speedLimit, capacity)));
     }
+    fclose(in);
     for (int i = 0; i < cntIntersections; i++) {
         intersections[i]->autoConnectAndLink();
     }
-    for (int i = 0; i < cntCars; i++) {
-        Car *c = getRandomCar(G, 0.0);
+    vector<Trip> trips = getRandomTrips(G, cntCars);
+    for (Car *c : createCars(G, trips, 0.0, sim->getPool())) {
         c->setSpeed(c->getCurrentRoad()->getSpeedLimit());
     }
     for (int i = 0; i < cntIntersections; i++) {
@@ -55,10 +64,12 @@ ConsoleDriver::ConsoleDriver(double iterationsPerSecond, string file, int contro
 }
 
 /**
- * Deconstructs the ConsoleDriver and the associated simulation.
+ * Deconstructs the ConsoleDriver, the associated simulation and the context of the run.
  */
 ConsoleDriver::~ConsoleDriver() {
     delete sim;
+    delete controller;
+    delete context;
 }
 
 /**
@@ -69,18 +80,14 @@ void ConsoleDriver::run() {
     auto start = chrono::high_resolution_clock::now();
     auto lastCarSpawn = chrono::high_resolution_clock::now();
     while (!exit) {
+        this_thread::sleep_until(start + chrono::duration<double>(iterationLength)); // waits for an iteration without spinning
         auto end = chrono::high_resolution_clock::now();
-        chrono::duration<double> elapsed = end - start;
-        while (elapsed.count() < iterationLength) { // waits for an iteration
-            end = chrono::high_resolution_clock::now();
-            elapsed = end - start;
-        }
         start = end;
         sim->nextIteration(iterationLength);
         chrono::duration<double> timeSinceLastCar = end - lastCarSpawn;
         if (timeSinceLastCar.count() >= 1.0 / ((double) carsPerSecond)) {
-            for (int i = 0; i < (int) floor(timeSinceLastCar.count() * ((double) carsPerSecond)); i++) {
-                Car *c = getRandomCar(G, sim->getCurrentTime());
+            vector<Trip> trips = getRandomTrips(G, (int) floor(timeSinceLastCar.count() * ((double) carsPerSecond)));
+            for (Car *c : createCars(G, trips, sim->getCurrentTime(), sim->getPool())) {
                 c->setSpeed(c->getCurrentRoad()->getSpeedLimit());
             }
             lastCarSpawn = end;
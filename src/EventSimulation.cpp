@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <limits>
+#include <assert.h>
+#include "EventSimulation.h"
+
+using namespace std;
+
+/**
+ * Compares this event to event e by time, then by the order they were scheduled.
+ * Greater than comparator.
+ */
+bool Event::operator > (const Event &e) const {
+    if (time != e.time) return time > e.time;
+    return sequence > e.sequence;
+}
+
+/**
+ * Initializes a new EventSimulation given a controller.
+ * @param controller the controller that will handle the traffic
+ * @param threads the number of threads used to route new cars (events are processed on the calling thread)
+ */
+EventSimulation::EventSimulation(Controller *controller, int threads) : Simulation(controller, threads) {
+    sequence = 0;
+    processed = 0;
+}
+
+/**
+ * Deconstructs the EventSimulation.
+ */
+EventSimulation::~EventSimulation() {}
+
+/**
+ * Advances the simulation by the specified time, processing every event in between in order.
+ * Cars added since the last call are scheduled first, from the front of each road to the back, so every car is
+ * scheduled after the car ahead of it. Signal changes are processed before car events at the same time.
+ * Controllers that decide by polling the traffic are checked at the end of each call, as in the time-step engine.
+ * @param timeElapsed the time elasped since the last call
+ */
+void EventSimulation::nextIteration(double timeElapsed) {
+    double end = currentTime + timeElapsed;
+    WeightedDigraph *G = controller->getGraph();
+    CarStore *store = G->getCarStore();
+    vector<RoadSegment*> roads; // the road segments that new cars were added to
+    for (CarHandle h : store->getNewCars()) {
+        if (store->isValid(h) && store->getRoads()[h.index] != nullptr) roads.push_back(store->getRoads()[h.index]);
+    }
+    store->getNewCars().clear();
+    sort(roads.begin(), roads.end(), [](RoadSegment *a, RoadSegment *b) { return a->getID() < b->getID(); });
+    roads.erase(unique(roads.begin(), roads.end()), roads.end());
+    for (RoadSegment *r : roads) {
+        for (int k = r->countCarsInQueue(); k < r->getFlow(); k++) {
+            if (!isScheduled(r->getCarAt(k))) scheduleArrival(r->getCarAt(k), r);
+        }
+    }
+    while (true) {
+        double control = min(controller->getNextEventTime(), end); // the controller is also checked at the end of each call
+        if (!events.empty() && events.top().time < control) {
+            Event e = events.top();
+            events.pop();
+            currentTime = max(currentTime, e.time);
+            processed++;
+            if (e.type == CAR_ARRIVAL) arrive(e);
+            else release(G->getCompiled()->getRoadSegment(e.target));
+            releaseWoken();
+        } else {
+            currentTime = max(currentTime, control);
+            controller->runEvents(currentTime);
+            releaseWoken();
+            if (control == end) break;
+        }
+    }
+    currentTime = end;
+    store->collect();
+    refreshRoutes();
+}
+
+/**
+ * Adds an event to the event queue.
+ * @param time the time the event occurs
+ * @param type the type of the event
+ * @param target the slot of the car for arrivals, the index of the road segment for releases
+ * @param version the version of the car's schedule for arrivals
+ */
+void EventSimulation::schedule(double time, int type, int target, int version) {
+    events.push({time, sequence++, type, target, version});
+}
+
+/**
+ * Returns true if the car with a handle has been scheduled, false if it is new or its slot was last scheduled for
+ * a car that has since left the simulation.
+ * @param h the handle of the car
+ */
+bool EventSimulation::isScheduled(CarHandle h) const {
+    return h.index < (int) handles.size() && version[h.index] > 0 && handles[h.index].generation == h.generation;
+}
+
+/**
+ * Schedules the time a car reaches the position where it leaves its road, from its speed and position.
+ * A car does not reach the stop line before the moving car ahead of it, if that car has been scheduled.
+ * @param h the handle of the car
+ * @param r the road segment the car is on
+ */
+void EventSimulation::scheduleArrival(CarHandle h, RoadSegment *r) {
+    CarStore *store = r->getGraph()->getCarStore();
+    int i = h.index;
+    if (i >= (int) arrival.size()) {
+        arrival.resize(i + 1);
+        entry.resize(i + 1);
+        version.resize(i + 1);
+        handles.resize(i + 1);
+    }
+    double time = currentTime + max(0.0, store->getTargets()[i] - store->getPositions()[i]) / store->getSpeeds()[i];
+    int k = r->getFlow() - 1; // cars usually enter at the source, so they are the last car on the road
+    while (r->getCarAt(k).index != i) k--;
+    if (k > r->countCarsInQueue() && isScheduled(r->getCarAt(k - 1))) time = max(time, arrival[r->getCarAt(k - 1).index]);
+    arrival[i] = time;
+    entry[i] = currentTime;
+    handles[i] = h;
+    version[i]++;
+    schedule(time, CAR_ARRIVAL, i, version[i]);
+}
+
+/**
+ * Processes a car reaching the position where it leaves its road. A car reaching its destination leaves the
+ * simulation. Otherwise the car joins the queue at the stop line, unless a car ahead of it is still moving.
+ * @param e the arrival event
+ */
+void EventSimulation::arrive(const Event &e) {
+    int i = e.target;
+    if (e.version != version[i]) return; // the car was rescheduled
+    CarStore *store = controller->getGraph()->getCarStore();
+    if (!store->isValid(handles[i])) return; // the car has left the simulation
+    Car *car = store->getCar(handles[i]);
+    RoadSegment *r = car->getCurrentRoad();
+    store->getPositions()[i] = min(store->getTargets()[i], store->getPositions()[i] + store->getSpeeds()[i] * (currentTime - entry[i]));
+    entry[i] = currentTime;
+    if (!car->hasNextRoad()) { // car has reached its destination
+        assert(r->removeCar(car) && "car not on road");
+        car->updateEfficiency(currentTime);
+        store->release(handles[i]);
+        return;
+    }
+    int k = r->countCarsInQueue();
+    while (r->getCarAt(k).index != i) k++;
+    if (k > r->countCarsInQueue()) { // a car ahead is still moving, so this car reaches the stop line after it
+        scheduleArrival(handles[i], r);
+        return;
+    }
+    assert(r->stop(handles[i]));
+    requestRelease(r, currentTime);
+}
+
+/**
+ * Lets the car at the front of the queue of a road segment leave if its light is green and the next road has room.
+ * Otherwise the queue goes to sleep until its light turns green or a car leaves the next road.
+ * @param r the road segment
+ */
+void EventSimulation::release(RoadSegment *r) {
+    if (pendingRelease[r->getIndex()] <= currentTime) pendingRelease[r->getIndex()] = numeric_limits<double>::infinity();
+    if (r->countCarsInQueue() == 0 || r->isAsleep()) return; // a queue that is asleep waits to be woken
+    if (currentTime < r->getLatestTime() + REACTION_TIME) {
+        requestRelease(r, r->getLatestTime() + REACTION_TIME);
+        return;
+    }
+    CarStore *store = r->getGraph()->getCarStore();
+    Car *car = r->getNextCarFromQueue();
+    if (car->hasNextRoad() && !r->getDestination()->isGreen(r, car->peekNextRoad())) {
+        r->waitForLight();
+        return;
+    } else if (car->hasNextRoad() && car->peekNextRoad()->getCapacity() - car->peekNextRoad()->getFlow() < 1) {
+        r->waitForRoom(car->peekNextRoad());
+        return;
+    }
+    r->removeNextCarFromQueue(currentTime);
+    assert(r->removeCar(car) && "car not on road");
+    if (car->hasNextRoad()) {
+        RoadSegment *rp = car->getNextRoad();
+        assert(rp->addCar(car) && "car was already on road");
+        recordTraversal(car, r);
+        scheduleArrival(car->getHandle(), rp);
+    } else { // car has reached destination
+        car->updateEfficiency(currentTime);
+        store->release(car->getHandle());
+    }
+    if (r->countCarsInQueue() > 0) requestRelease(r, currentTime + REACTION_TIME);
+}
+
+/**
+ * Schedules a release of a road segment, unless one is already scheduled at or before the specified time.
+ * @param r the road segment
+ * @param time the time of the release
+ */
+void EventSimulation::requestRelease(RoadSegment *r, double time) {
+    if ((int) pendingRelease.size() < controller->getGraph()->getCompiled()->countRoadSegments()) {
+        pendingRelease.resize(controller->getGraph()->getCompiled()->countRoadSegments(), numeric_limits<double>::infinity());
+    }
+    if (pendingRelease[r->getIndex()] <= time) return;
+    pendingRelease[r->getIndex()] = time;
+    schedule(time, ROAD_RELEASE, r->getIndex(), 0);
+}
+
+/**
+ * Schedules a release of every road segment whose waiting queue was woken by a light turning green or by a car
+ * leaving the full road it was waiting on.
+ */
+void EventSimulation::releaseWoken() {
+    vector<RoadSegment*> &woken = controller->getGraph()->getWokenRoadSegments();
+    for (RoadSegment *r : woken) {
+        if (r->countCarsInQueue() > 0) requestRelease(r, currentTime);
+    }
+    woken.clear();
+}
+
+/**
+ * Updates the positions of the moving cars to the current time. Positions are otherwise only updated at events,
+ * so this should be called before the cars are drawn.
+ */
+void EventSimulation::updatePositions() {
+    CarStore *store = controller->getGraph()->getCarStore();
+    for (RoadSegment *r : controller->getGraph()->getActiveRoadSegments()) {
+        for (int k = r->countCarsInQueue(); k < r->getFlow(); k++) {
+            if (!isScheduled(r->getCarAt(k))) continue; // the car has not been scheduled yet
+            int i = r->getCarAt(k).index;
+            store->getPositions()[i] = min(store->getTargets()[i], store->getPositions()[i] + store->getSpeeds()[i] * (currentTime - entry[i]));
+            entry[i] = currentTime;
+        }
+    }
+}
+
+/**
+ * Returns the number of events processed so far.
+ */
+long long EventSimulation::getEventsProcessed() const { return processed; }
@@ -0,0 +1,58 @@
+#ifndef EVENTSIMULATION_H_
+#define EVENTSIMULATION_H_
+
+#include <functional>
+#include <queue>
+#include <vector>
+#include "Simulation.h"
+
+// types of simulation events
+#define CAR_ARRIVAL 0
+#define ROAD_RELEASE 1
+
+/**
+ * An event in the discrete event simulation. Ties in time are broken by the order the events were scheduled.
+ */
+struct Event {
+    double time; // the time the event occurs
+    long long sequence; // the order the event was scheduled in
+    int type; // the type of the event
+    int target; // the slot of the car for arrivals, the index of the road segment for releases
+    int version; // the version of the car's schedule for arrivals (stale arrivals are skipped)
+
+    bool operator > (const Event &e) const;
+};
+
+/**
+ * Simulates the traffic in the city by jumping from event to event instead of advancing every car at a fixed time step.
+ * The time a car reaches the stop line (or its destination) is computed from its speed when it enters a road, cars
+ * wait in a queue at the stop line, and queues are released when they are woken by their light or their next road.
+ */
+struct EventSimulation : public Simulation {
+private:
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events; // the scheduled events
+    long long sequence; // the number of events scheduled so far
+    long long processed; // the number of events processed so far
+    std::vector<double> arrival; // the time the car in each slot reaches the position where it leaves its road
+    std::vector<double> entry; // the time the position of the car in each slot was last updated
+    std::vector<int> version; // the version of the schedule of the car in each slot
+    std::vector<CarHandle> handles; // the handle of the car in each slot when it was last scheduled
+    std::vector<double> pendingRelease; // the time of the scheduled release of each road segment (by index), infinity if none
+
+    bool isScheduled(CarHandle h) const;
+    void schedule(double time, int type, int target, int version);
+    void scheduleArrival(CarHandle h, RoadSegment *r);
+    void arrive(const Event &e);
+    void release(RoadSegment *r);
+    void requestRelease(RoadSegment *r, double time);
+    void releaseWoken();
+
+public:
+    EventSimulation(Controller *controller, int threads = 1);
+    ~EventSimulation();
+    void nextIteration(double timeElapsed);
+    void updatePositions();
+    long long getEventsProcessed() const;
+};
+
+#endif
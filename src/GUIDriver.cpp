@@ -1,5 +1,7 @@
 #include <chrono>
+#include <thread>
 #include <cmath>
+#include <ctime>
 #include <assert.h>
 #include <QString>
 #include <QFile>
@@ -9,6 +11,7 @@
 #include "GUIDriver.h"
 #include "controller/PretimedController.h"
 #include "controller/BasicController.h"
+#include "controller/MaxPressureController.h"
 
 using namespace std;
 
@@ -18,7 +21,7 @@ using namespace std;
  * @param argv should be the array of arguments from main
  * @param iterationsPerSecond the number of iterations to be executed in the simulator per second
  * @param fileName the file to load the city
- * @param controllerType 0 if PretimedController, 1 for BasicController
+ * @param controllerType 0 if PretimedController, 1 for BasicController, 2 for MaxPressureController
  */
 GUIDriver::GUIDriver(int argc, char *argv[], double iterationsPerSecond, string fileName, int controllerType) {
     assert(iterationsPerSecond > 0.0 && "iterationsPerSecond must be a positive value");
@@ -29,10 +32,14 @@ GUIDriver::GUIDriver(int argc, char *argv[], double iterationsPerSecond, string
     assert(file.exists() && "unable to open file");
     file.open(QIODevice::ReadOnly | QIODevice::Text);
     QTextStream in(&file);
-    G = new WeightedDigraph();
+    context = new SimulationContext();
+    G = context->getGraph();
+    G->setSeed(time(0)); // every run is different
     if (controllerType == 0) controller = new PretimedController(G);
     else if (controllerType == 1) controller = new BasicController(G);
+    else if (controllerType == 2) controller = new MaxPressureController(G);
     sim = new Simulation(controller);
+    G->setPool(sim->getPool());
     int cntIntersections;
     int cntRoadSegments;
     int cntCars;
@@ -42,7 +49,7 @@ GUIDriver::GUIDriver(int argc, char *argv[], double iterationsPerSecond, string
         double x;
         double y;
         in >> x >> y;
-        intersections[i] = new Intersection(x, y);
+        intersections[i] = new Intersection(context, x, y);
     }
     for (int i = 0; i < cntRoadSegments; i++) {
         int A;
@@ -55,9 +62,9 @@ GUIDriver::GUIDriver(int argc, char *argv[], double iterationsPerSecond, string
     for (int i = 0; i < cntIntersections; i++) {
         intersections[i]->autoConnectAndLink();
     }
-    for (int i = 0; i < cntCars; i++) {
-        Car *c = getRandomCar(G, 0.0);
-        c->setSpeed(c->getCurrentRoad()->getRandomSpeed());
+    vector<Trip> trips = getRandomTrips(G, cntCars);
+    for (Car *c : createCars(G, trips, 0.0, sim->getPool())) {
+        c->setSpeed(c->getCurrentRoad()->getRandomSpeed(c));
     }
     for (int i = 0; i < cntIntersections; i++) {
         controller->addEvent(0.0, intersections[i]->getID());
@@ -70,13 +77,15 @@ GUIDriver::GUIDriver(int argc, char *argv[], double iterationsPerSecond, string
 }
 
 /**
- * Deconstructs the GUIDriver and the associated simulation.
+ * Deconstructs the GUIDriver, the associated simulation and the context of the run.
  */
 GUIDriver::~GUIDriver() {
     delete sim;
     delete gui;
     delete eventLoop;
     delete app;
+    delete controller;
+    delete context;
 }
 
 /**
@@ -87,19 +96,15 @@ void GUIDriver::run() {
     auto start = chrono::high_resolution_clock::now();
     auto lastCarSpawn = chrono::high_resolution_clock::now();
     while (!exit) {
+        this_thread::sleep_until(start + chrono::duration<double>(iterationLength)); // waits for an iteration without spinning
         auto end = chrono::high_resolution_clock::now();
-        chrono::duration<double> elapsed = end - start;
-        while (elapsed.count() < iterationLength) { // waits for an iteration
-            end = chrono::high_resolution_clock::now();
-            elapsed = end - start;
-        }
         start = end;
         sim->nextIteration(iterationLength);
         chrono::duration<double> timeSinceLastCar = end - lastCarSpawn;
         if (timeSinceLastCar.count() >= 1.0 / ((double) carsPerSecond)) {
-            for (int i = 0; i < (int) floor(timeSinceLastCar.count() * ((double) carsPerSecond)); i++) {
-                Car *c = getRandomCar(G, sim->getCurrentTime());
-                c->setSpeed(c->getCurrentRoad()->getRandomSpeed());
+            vector<Trip> trips = getRandomTrips(G, (int) floor(timeSinceLastCar.count() * ((double) carsPerSecond)));
+            for (Car *c : createCars(G, trips, sim->getCurrentTime(), sim->getPool())) {
+                c->setSpeed(c->getCurrentRoad()->getRandomSpeed(c));
             }
             lastCarSpawn = end;
         }
@@ -19,6 +19,7 @@ private:
     GUI *gui; // the GUI object
     Controller *controller; // the traffic controller
     Simulation *sim; // the simulation being run
+    SimulationContext *context; // the state of the run, which owns the city
     WeightedDigraph *G; // the city represented as a weighted directed graph
     double iterationsPerSecond; // the number of iterations per second the simulation should execute
     double iterationLength; // the length of one iteration
@@ -0,0 +1,135 @@
+#include <cstdio>
+#include <chrono>
+#include <assert.h>
+#include "HeadlessDriver.h"
+#include "EventSimulation.h"
+#include "controller/PretimedController.h"
+#include "controller/BasicController.h"
+#include "controller/MaxPressureController.h"
+
+using namespace std;
+
+/**
+ * Initializes a new HeadlessDriver.
+ * @param iterationLength the simulated time that passes in one iteration (must be a positive value)
+ * @param file the file to load the city
+ * @param controllerType 0 if PretimedController, 1 for BasicController, 2 for MaxPressureController
+ * @param simulationType 0 to advance every car at each iteration, 1 to jump from event to event
+ * @param threads the number of threads used to route new cars, and to update the road segments when advancing every car
+ * @param seed the seed of the run (the same seed gives the same run for any number of threads)
+ * @param routingMode the algorithm used to find the routes of cars, ROUTING_DIJKSTRA, ROUTING_ALT, ROUTING_CH,
+ * ROUTING_TABLES, ROUTING_LIVE, ROUTING_TURNS or ROUTING_SIGNALS
+ */
+HeadlessDriver::HeadlessDriver(double iterationLength, string file, int controllerType, int simulationType, int threads, unsigned long long seed, int routingMode) {
+    assert(iterationLength > 0.0 && "iterationLength must be a positive value");
+    this->iterationLength = iterationLength;
+    pendingCars = 0.0;
+    carsSpawned = 0;
+    FILE *in = fopen(file.c_str(), "r");
+    assert(in != nullptr && "unable to open file");
+    context = new SimulationContext();
+    G = context->getGraph();
+    G->setSeed(seed);
+    G->setRoutingMode(routingMode);
+    if (controllerType == 0) controller = new PretimedController(G);
+    else if (controllerType == 1) controller = new BasicController(G);
+    else if (controllerType == 2) controller = new MaxPressureController(G);
+    if (simulationType == 0) sim = new Simulation(controller, threads);
+    else if (simulationType == 1) sim = new EventSimulation(controller, threads);
+    G->setPool(sim->getPool());
+    int cntIntersections;
+    int cntRoadSegments;
+    int cntCars;
+    fscanf(in, "%d %d %d %d", &cntIntersections, &cntRoadSegments, &cntCars, &carsPerSecond);
+    Intersection *intersections[cntIntersections];
+    for (int i = 0; i < cntIntersections; i++) {
+        double x;
+        double y;
+        fscanf(in, "%lf %lf", &x, &y);
+        intersections[i] = new Intersection(context, x, y);
+    }
+    for (int i = 0; i < cntRoadSegments; i++) {
+        int A;
+        int B;
+        double speedLimit;
+        int capacity;
+        fscanf(in, "%d %d %lf %d", &A, &B, &speedLimit, &capacity);
+        assert(G->addRoadSegment(new RoadSegment(intersections[A], intersections[B], speedLimit, capacity)));
+    }
+    fclose(in);
+    for (int i = 0; i < cntIntersections; i++) {
+        intersections[i]->autoConnectAndLink();
+    }
+    if (routingMode == ROUTING_CH) G->getHierarchy()->printStatistics();
+    vector<Trip> trips = getRandomTrips(G, cntCars);
+    for (Car *c : createCars(G, trips, 0.0, sim->getPool())) {
+        c->setSpeed(c->getCurrentRoad()->getRandomSpeed(c));
+        carsSpawned++;
+    }
+    for (int i = 0; i < cntIntersections; i++) {
+        controller->addEvent(0.0, intersections[i]->getID());
+    }
+}
+
+/**
+ * Deconstructs the HeadlessDriver, the associated simulation and the context of the run.
+ */
+HeadlessDriver::~HeadlessDriver() {
+    delete sim;
+    delete controller;
+    delete context;
+}
+
+/**
+ * Spawns the cars that are owed for the simulated time that has passed.
+ * Fractions of a car are carried over to the next iteration so the spawn rate does not depend on the iteration length.
+ * @param timeElapsed the simulated time elapsed since the last spawn
+ */
+void HeadlessDriver::spawnCars(double timeElapsed) {
+    pendingCars += timeElapsed * (double) carsPerSecond;
+    int n = (int) pendingCars;
+    if (n == 0) return;
+    pendingCars -= n;
+    vector<Trip> trips = getRandomTrips(G, n);
+    for (Car *c : createCars(G, trips, sim->getCurrentTime(), sim->getPool())) {
+        c->setSpeed(c->getCurrentRoad()->getRandomSpeed(c));
+        carsSpawned++;
+    }
+}
+
+/**
+ * Runs the simulation without a display until the target simulated time or the target number of cars
+ * reaching their destination is hit, then prints a summary of the run.
+ * @param targetTime the simulated time to stop at (a negative value means no limit)
+ * @param targetCars the number of cars that reach their destination to stop at (a negative value means no limit)
+ */
+void HeadlessDriver::run(double targetTime, int targetCars) {
+    assert((targetTime >= 0.0 || targetCars >= 0) && "the run must have a target time or a target number of cars");
+    int iterations = 0;
+    int startReached = context->getReached();
+    double startTime = sim->getCurrentTime();
+    auto start = chrono::high_resolution_clock::now();
+    while ((targetTime < 0.0 || sim->getCurrentTime() < targetTime) && (targetCars < 0 || context->getReached() - startReached < targetCars)) {
+        sim->nextIteration(iterationLength);
+        spawnCars(iterationLength);
+        iterations++;
+    }
+    auto end = chrono::high_resolution_clock::now();
+    chrono::duration<double> elapsed = end - start;
+    printf("simulated time: %.2f s\n", sim->getCurrentTime());
+    printf("wall time: %.2f s\n", elapsed.count());
+    printf("simulated seconds per wall second: %.2f\n", elapsed.count() > 0.0 ? (sim->getCurrentTime() - startTime) / elapsed.count() : 0.0);
+    printf("iterations: %d\n", iterations);
+    printf("cars spawned: %d\n", carsSpawned);
+    printf("cars reached destination: %d\n", context->getReached() - startReached);
+    printf("efficiency: %.2f%%\n", context->getEfficiency() * 100.0);
+    const TimerQueue &timers = controller->getTimers();
+    double perSecond = sim->getCurrentTime() > startTime ? 1.0 / (sim->getCurrentTime() - startTime) : 0.0; // converts counts to rates per simulated second
+    printf("signal timers: %d pending, %d at most\n", timers.size(), timers.getPeak());
+    printf("signal timer operations per simulated second: %.2f scheduled, %.2f rescheduled, %.2f cancelled, %.2f fired\n", timers.countScheduled() * perSecond, timers.countRescheduled() * perSecond, timers.countCancelled() * perSecond, timers.countFired() * perSecond);
+}
+
+/**
+ * Returns the context of the run, which holds the statistics of the cars that reached their destination.
+ */
+SimulationContext *HeadlessDriver::getContext() const { return context; }
@@ -0,0 +1,32 @@
+#ifndef HEADLESSDRIVER_H_
+#define HEADLESSDRIVER_H_
+
+#include <string>
+#include "controller/Controller.h"
+#include "Simulation.h"
+#include "framework/Framework.h"
+
+/**
+ * The driver behind headless runs. Iterations are executed as fast as possible and are not tied to the wall clock.
+ */
+struct HeadlessDriver {
+private:
+    Controller *controller; // the traffic controller
+    Simulation *sim; // the simulation being run
+    SimulationContext *context; // the state of the run, which owns the city
+    WeightedDigraph *G; // the city represented as a weighted directed graph
+    double iterationLength; // the simulated length of one iteration
+    int carsPerSecond; // the number of cars added per simulated second
+    double pendingCars; // the fraction of a car that is owed to the spawner
+    int carsSpawned; // the number of cars spawned during the run
+
+    void spawnCars(double timeElapsed);
+
+public:
+    HeadlessDriver(double iterationLength, std::string file, int controllerType, int simulationType = 0, int threads = 1, unsigned long long seed = 0, int routingMode = ROUTING_DIJKSTRA);
+    ~HeadlessDriver();
+    void run(double targetTime, int targetCars);
+    SimulationContext *getContext() const;
+};
+
+#endif
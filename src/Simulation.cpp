@@ -1,128 +1,216 @@
 #include <utility>
 #include <cmath>
-#include <unordered_set>
 #include <assert.h>
 #include "Simulation.h"
 #include "controller/PretimedController.h"
-#include "misc/pair_hash.h"
 
 using namespace std;
 
 /**
  * Initializes a new Simulation given a controller.
  * @param controller the controller that will handle the traffic
+ * @param threads the number of threads used to update the road segments and route new cars (must be a positive integer)
  */
-Simulation::Simulation(Controller *controller) {
+Simulation::Simulation(Controller *controller, int threads) {
+    assert(threads > 0 && "threads must be a positive integer");
     this->controller = controller;
     currentTime = 0.0;
+    pool = new ThreadPool(threads);
+    lastRefresh = 0.0;
+    rerouteBudget = REROUTE_BUDGET;
 }
 
 /**
  * Deconstructs the Simulation.
  */
-Simulation::~Simulation() {}
+Simulation::~Simulation() {
+    delete pool;
+}
 
 /**
  * Returns the current time in the simulation.
  */
 double Simulation::getCurrentTime() { return currentTime; }
 
+/**
+ * Returns a pointer to the threads of the simulation, which can also be used to route new cars between iterations.
+ */
+ThreadPool *Simulation::getPool() { return pool; }
+
+/**
+ * Sets the most intersections visited in each refresh of the live routing tables. Tables that are not refreshed
+ * in time keep their routes until a later refresh.
+ * @param budget the number of intersections (must be a positive integer)
+ */
+void Simulation::setRerouteBudget(int budget) {
+    assert(budget > 0 && "budget must be a positive integer");
+    rerouteBudget = budget;
+}
+
+/**
+ * Records that a car moved from a road segment onto the next road on its path. With live routing, the time the car
+ * took to travel the road segment is added to its travel time.
+ * @param car the car, which is already on its next road
+ * @param r the road segment the car left
+ */
+void Simulation::recordTraversal(Car *car, RoadSegment *r) {
+    WeightedDigraph *G = controller->getGraph();
+    double &entered = G->getCarStore()->getEntryTimes()[car->getHandle().index];
+    if (G->getRoutingMode() == ROUTING_LIVE && entered >= 0.0) G->getTravelTimes()->observe(r->getIndex(), currentTime - entered, currentTime);
+    entered = currentTime;
+}
+
+/**
+ * Publishes the live travel times and refreshes the routing tables every REROUTE_PERIOD seconds, if the cars use
+ * live routing.
+ */
+void Simulation::refreshRoutes() {
+    WeightedDigraph *G = controller->getGraph();
+    if (G->getRoutingMode() != ROUTING_LIVE || currentTime < lastRefresh + REROUTE_PERIOD) return;
+    lastRefresh = currentTime;
+    G->getTravelTimes()->publish(G, currentTime);
+    G->getRoutingTables()->refresh(rerouteBudget);
+}
+
 /**
  * Performs the next iteration in the simulation.
+ * Only the road segments with cars on them or scheduled to be on them are visited. They are updated in two phases. First, the cars on each road segment are moved and the cars that
+ * will leave their road are decided, in parallel. Only the road segment being updated and its cars are modified in
+ * this phase. Second, the transfers are committed one road segment at a time in a fixed order, checking the capacity
+ * of the next road. The result does not depend on the number of threads.
  * @param timeElapsed the time elasped since the last iteration
  */
 void Simulation::nextIteration(double timeElapsed) {
     currentTime += timeElapsed;
-    controller->runEvents(currentTime);
+    controller->runEvents(currentTime); // lights turning green wake the queues waiting on them
     WeightedDigraph *G = controller->getGraph();
-    unordered_set<int> done;
-    unordered_set<pair<int, int>, pair_hash<int, int>> toDelete;
-    // PRE CHECK
-    // for (pair<int, RoadSegment*> r : G->getRoadSegments()) {
-    //     for (pair<int, Car*> c : r.second->getCars()) {
-    //         assert(c.second != nullptr);
-    //         if (c.second->hasNextRoad()) {
-    //             // assert(c.second->peekNextRoad()->incoming.count(c.first));
-    //             assert(r.second->getDestination()->isConnected(r.first, c.second->peekNextRoad()->getID()));
-    //         }
-    //     }
-    // }
-    for (pair<int, RoadSegment*> r : G->getRoadSegments()) {
-        Point2D dest = r.second->getDestination()->getLocation();
-        // HANDLES CARS WAITING IN THE QUEUE TO EXIT INTERSECTION
-        if (r.second->countCarsInQueue() > 0 && r.second->getLatestTime() + REACTION_TIME <= currentTime) {
-            Car *c = r.second->getNextCarFromQueue();
-            done.insert(c->getID());
-            if (!c->hasNextRoad() || (r.second->getDestination()->getLightBetween(r.first, c->peekNextRoad()->getID())->getState() == GREEN
-                    && c->peekNextRoad()->getCapacity() - c->peekNextRoad()->getFlow() >= 1)) {
-                r.second->removeNextCarFromQueue(currentTime);
-                c->setLocation(dest);
-                assert(r.second->removeCar(c) && "car not on road");
-                if (c->hasNextRoad()) {
-                    RoadSegment *rp = c->getNextRoad();
-                    assert(rp->addCar(c) && "car was already on road");
-                    c->setLocation(dest);
-                } else { // car has reached destination
-                    c->updateEfficiency(currentTime);
-                    delete c;
-                }
-            }
+    G->getWokenRoadSegments().clear(); // woken queues are checked because they are awake
+    G->getCarStore()->getNewCars().clear(); // every car is moved each iteration
+    roads = G->getActiveRoadSegments(); // idle road segments are skipped, and the set changes while committing
+    if (transfers.size() < roads.size()) transfers.resize(roads.size());
+    pool->parallelFor(roads.size(), ROADS_PER_TASK, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            transfers[i].clear();
+            moveCars(roads[i], timeElapsed, transfers[i]);
         }
-        toDelete.clear();
-        // HANDLES CARS TRAVELLING AT ROAD SPEED
-        for (pair<int, Car*> c : r.second->getCars()) {
-            if (done.count(c.first) == 0 && !r.second->isStopped(c.first)) {
-                done.insert(c.first);
-                double dx = (timeElapsed * c.second->getCurrentSpeed()) * cos(c.second->getCurrentLocation().angleTo(dest));
-                double dy = (timeElapsed * c.second->getCurrentSpeed()) * sin(c.second->getCurrentLocation().angleTo(dest));
-                Point2D newLoc(c.second->getCurrentLocation().x + dx, c.second->getCurrentLocation().y + dy);
-                c.second->setLocation(newLoc);
-                double eps_dist = timeElapsed * c.second->getCurrentSpeed() * 0.51; // max distance between frames
-                if (c.second->getDestination().distanceTo(newLoc) <= eps_dist && r.first == c.second->getFinalRoad()->getID()) {
-                    toDelete.insert(make_pair(c.first, 1)); // type 1 means car has reached its destination
-                } else if (r.second->countCarsInQueue() > 0 && r.second->getLastCarInQueue()->getCurrentLocation().distanceTo(newLoc) <= eps_dist) {
-                    assert(r.second->stop(c.first)); // if there are cars stopped ahead, then this car should also stop
-                } else if (dest.distanceTo(newLoc) <= eps_dist) {
-                    if (!c.second->hasNextRoad() || (r.second->getDestination()->getLightBetween(r.first, c.second->peekNextRoad()->getID())->getState() == GREEN
-                            && c.second->peekNextRoad()->getCapacity() - c.second->peekNextRoad()->getFlow() >= 1)) {
-                        toDelete.insert(make_pair(c.first, 2)); // type 2 means car has reached the end of the road
-                    } else {
-                        assert(r.second->stop(c.first)); // car is waiting to move off the road
-                    }
-                }
+    });
+    for (int i = 0; i < (int) roads.size(); i++) {
+        commitTransfers(roads[i], transfers[i]);
+    }
+    G->getCarStore()->collect(); // cars that reached their destination are deleted together
+    refreshRoutes();
+}
+
+/**
+ * Moves the cars on a road segment and decides which cars will leave it. Cars that have to wait are stopped.
+ * Only the road segment and the cars on it are modified, so road segments can be updated concurrently.
+ * Cars are visited from the destination to the source and never pass the car ahead of them. A waiting queue that
+ * is asleep is not checked, since neither its light nor the room on its next road has changed.
+ * @param r the road segment
+ * @param timeElapsed the time elasped since the last iteration
+ * @param out the transfers decided for the road segment
+ */
+void Simulation::moveCars(RoadSegment *r, double timeElapsed, vector<Transfer> &out) {
+    int queued = r->countCarsInQueue();
+    int firstMoving = queued;
+    // HANDLES CARS WAITING IN THE QUEUE TO EXIT INTERSECTION
+    if (queued > 0 && !r->isAsleep() && r->getLatestTime() + REACTION_TIME <= currentTime) {
+        Car *c = r->getNextCarFromQueue();
+        if (!c->hasNextRoad() || (r->getDestination()->isGreen(r, c->peekNextRoad())
+                && c->peekNextRoad()->getCapacity() - c->peekNextRoad()->getFlow() >= 1)) {
+            out.push_back({c, LEAVING_QUEUE});
+            queued--; // the cars behind do not have to stop for this car
+        } else {
+            out.push_back({c, WAITING_IN_QUEUE});
+        }
+    }
+    CarStore *store = r->getGraph()->getCarStore();
+    vector<double> &position = store->getPositions();
+    vector<double> &target = store->getTargets();
+    vector<double> &speed = store->getSpeeds();
+    // the closest car ahead that stays on the road
+    bool hasLeader = queued > 0;
+    bool leaderStopped = queued > 0;
+    double leaderPosition = queued > 0 ? position[r->getCarAt(firstMoving - 1).index] : r->getLength();
+    // HANDLES CARS TRAVELLING AT ROAD SPEED
+    for (int k = firstMoving; k < r->getFlow(); k++) {
+        CarHandle h = r->getCarAt(k);
+        int i = h.index;
+        double dist = timeElapsed * speed[i];
+        position[i] = min(position[i] + dist, leaderPosition);
+        double eps_dist = dist * 0.51; // max distance between frames
+        bool nearTarget = target[i] - position[i] <= eps_dist;
+        Car *car = nearTarget ? store->getCar(h) : nullptr;
+        if (nearTarget && !car->hasNextRoad()) { // the target of a car on its final road is its destination
+            out.push_back({car, REACHED_DESTINATION});
+            continue;
+        } else if (leaderStopped && leaderPosition - position[i] <= eps_dist) {
+            assert(r->stop(h)); // if there are cars stopped ahead, then this car should also stop
+        } else if (nearTarget && !hasLeader) {
+            if (r->getDestination()->isGreen(r, car->peekNextRoad())
+                    && car->peekNextRoad()->getCapacity() - car->peekNextRoad()->getFlow() >= 1) {
+                out.push_back({car, REACHED_END_OF_ROAD});
+            } else {
+                assert(r->stop(h)); // car is waiting to move off the road
             }
         }
-        // DELETES CARS THAT HAVE REACHED THE DESTINATION
-        for (pair<int, int> c : toDelete) {
-            Car *car = r.second->getCar(c.first);
-            if (c.second == 1) { // type 1 means car has reached its destination
-                assert(r.second->removeCar(car) && "car not on road");
-                car->updateEfficiency(currentTime);
-                delete car;
-            } else if (car->hasNextRoad()) {
-                if (car->peekNextRoad()->getCapacity() - car->peekNextRoad()->getFlow() < 1) {
-                    assert(r.second->stop(c.first));
-                } else {
-                    assert(r.second->removeCar(car) && "car not on road");
-                    RoadSegment *rp = car->getNextRoad();
-                    assert(rp->addCar(car) && "car was already on road");
-                    car->setLocation(dest);
-                }
-            } else { // car has reached end the of road, and also its destination
-                assert(r.second->removeCar(car) && "car not on road");
+        hasLeader = true;
+        leaderStopped = store->getStopped()[i];
+        leaderPosition = position[i];
+    }
+}
+
+/**
+ * Commits the transfers decided for a road segment. The capacity of the next road is checked again since
+ * transfers from other road segments may have been committed before. Cars that reach their destination are
+ * released from the car store. A queue that cannot leave subscribes to its light or to its full next road.
+ * @param r the road segment
+ * @param in the transfers decided for the road segment
+ */
+void Simulation::commitTransfers(RoadSegment *r, vector<Transfer> &in) {
+    CarStore *store = r->getGraph()->getCarStore();
+    bool blocked = false; // whether a car at the front stays on the road, so the cars behind it cannot leave
+    for (Transfer &t : in) {
+        Car *car = t.car;
+        if (t.type == WAITING_IN_QUEUE) {
+            if (!r->getDestination()->isGreen(r, car->peekNextRoad())) r->waitForLight();
+            else if (car->peekNextRoad()->getCapacity() - car->peekNextRoad()->getFlow() < 1) r->waitForRoom(car->peekNextRoad());
+            // otherwise a car left the next road earlier in this iteration, so the queue stays awake
+            blocked = true;
+        } else if (t.type == LEAVING_QUEUE) {
+            if (car->hasNextRoad() && car->peekNextRoad()->getCapacity() - car->peekNextRoad()->getFlow() < 1) { // stays at the front of the queue
+                r->waitForRoom(car->peekNextRoad());
+                blocked = true;
+                continue;
+            }
+            r->removeNextCarFromQueue(currentTime);
+            assert(r->removeCar(car) && "car not on road");
+            if (car->hasNextRoad()) {
+                RoadSegment *rp = car->getNextRoad();
+                assert(rp->addCar(car) && "car was already on road");
+                recordTraversal(car, r);
+            } else { // car has reached destination
                 car->updateEfficiency(currentTime);
-                delete car;
+                store->release(car->getHandle());
+            }
+        } else if (t.type == REACHED_DESTINATION) {
+            assert(r->removeCar(car) && "car not on road");
+            car->updateEfficiency(currentTime);
+            store->release(car->getHandle());
+        } else if (car->hasNextRoad()) {
+            if (blocked || car->peekNextRoad()->getCapacity() - car->peekNextRoad()->getFlow() < 1) {
+                assert(r->stop(car->getHandle()));
+                blocked = true;
+            } else {
+                assert(r->removeCar(car) && "car not on road");
+                RoadSegment *rp = car->getNextRoad();
+                assert(rp->addCar(car) && "car was already on road");
+                recordTraversal(car, r);
             }
+        } else { // car has reached end the of road, and also its destination
+            assert(r->removeCar(car) && "car not on road");
+            car->updateEfficiency(currentTime);
+            store->release(car->getHandle());
         }
     }
-    // POST CHECK
-    // for (pair<int, RoadSegment*> r : G->getRoadSegments()) {
-    //     for (pair<int, Car*> c : r.second->getCars()) {
-    //         assert(c.second != nullptr);
-    //         if (c.second->hasNextRoad()) {
-    //             // assert(c.second->peekNextRoad()->incoming.count(c.first));
-    //             assert(r.second->getDestination()->isConnected(r.first, c.second->peekNextRoad()->getID()));
-    //         }
-    //     }
-    // }
 }
@@ -1,24 +1,59 @@
 #ifndef SIMULATION_H_
 #define SIMULATION_H_
 
+#include <vector>
 #include "controller/Controller.h"
 #include "framework/Framework.h"
+#include "misc/ThreadPool.h"
 
 #define REACTION_TIME 0.1
+#define ROADS_PER_TASK 16 // the number of road segments a worker takes at a time
+#define REROUTE_PERIOD 1.0 // the seconds between refreshes of the live routing tables
+#define REROUTE_BUDGET 100000 // the most intersections visited in each refresh of the live routing tables
+
+// reasons for a car to leave its road segment
+#define LEAVING_QUEUE 0
+#define REACHED_DESTINATION 1
+#define REACHED_END_OF_ROAD 2
+#define WAITING_IN_QUEUE 3 // the car at the front of the queue cannot leave, so the queue goes to sleep
+
+/**
+ * A car leaving its road segment, or a queue going to sleep. Transfers are decided in parallel and then committed
+ * in a deterministic order.
+ */
+struct Transfer {
+    Car *car; // the car leaving the road
+    int type; // the reason the car is leaving the road
+};
 
 /**
  * Simulates the traffic in the city
  */
 struct Simulation {
-private:
+protected:
     Controller *controller; // the traffic controller
     double currentTime; // the time elapsed in the simulation
 
+    void recordTraversal(Car *car, RoadSegment *r);
+    void refreshRoutes();
+
+private:
+    ThreadPool *pool; // the threads that update the road segments and route new cars
+    std::vector<RoadSegment*> roads; // the active road segments at the start of the iteration, in the order the transfers are committed
+    std::vector<std::vector<Transfer>> transfers; // the transfers decided for each road segment in the current iteration
+    double lastRefresh; // the time the live routing tables were last refreshed
+    int rerouteBudget; // the most intersections visited in each refresh of the live routing tables
+
+    void moveCars(RoadSegment *r, double timeElapsed, std::vector<Transfer> &out);
+    void commitTransfers(RoadSegment *r, std::vector<Transfer> &in);
+
 public:
-    Simulation(Controller *controller);
-    ~Simulation();
+    Simulation(Controller *controller, int threads = 1);
+    virtual ~Simulation();
     double getCurrentTime();
-    void nextIteration(double timeElapsed);
+    ThreadPool *getPool();
+    void setRerouteBudget(int budget);
+    virtual void nextIteration(double timeElapsed);
 };
 
 #endif
@@ -1,3 +1,3 @@
- g++ ConsoleDriver.cpp Simulation.cpp main.cpp framework/*.cpp controller/*.cpp -std=c++14
+ g++ ConsoleDriver.cpp HeadlessDriver.cpp Simulation.cpp EventSimulation.cpp main.cpp framework/*.cpp controller/*.cpp -std=c++14 -pthread
  read -p "Press enter to exit"
  
\ No newline at end of file
@@ -15,13 +15,14 @@ BasicController::BasicController(WeightedDigraph *G) : Controller(G) {}
 BasicController::~BasicController() {}
 
 /**
- * Adds an event with a specified intersection ID at a specified time.
+ * Adds an event with a specified intersection ID at a specified time, replacing the pending event of the intersection.
  * The event is when the traffic signal is scheduled to be cycled.
  * @param time the specified time the event will occur
  * @param id the intersection ID of the event
  */
 void BasicController::addEvent(double time, int id) {
-    events.push(make_pair(time, id));
+    G->getCompiled(); // the intersections get their indices
+    timers.schedule(G->getIntersection(id)->getIndex(), time);
 }
 
 /**
@@ -30,26 +31,50 @@ void BasicController::addEvent(double time, int id) {
  * @param currentTime the current time
  */
 bool BasicController::checkNextEvent(double currentTime) const {
-    return currentTime >= events.top().first;
+    return currentTime >= timers.getNextTime();
 }
 
 /**
  * Runs the events that are before or at the current time that have not yet been run and adds the
- * next events to the event queue.
+ * next events to the event queue. An intersection that is due to cycle keeps its pending event instead of
+ * getting another one at every check, so each intersection has at most one pending event.
+ * Only the intersections that cycled, whose demand changed, or that passed MIN_TIME or MAX_TIME since their last cycle
+ * are checked, since the decision of any other intersection is the same as at its last check.
  * @param currentTime the current time
  */
 void BasicController::runEvents(double currentTime) {
-    while (!events.empty() && events.top().first <= currentTime) {
-        Intersection *n = G->getIntersection(events.top().second);
-        events.pop();
+    while (!timers.empty() && timers.getNextTime() <= currentTime) {
+        Intersection *n = G->getCompiled()->getIntersection(timers.pop());
         n->cycle(currentTime);
-        if (n->leftTurnSignalOn()) events.push(make_pair(currentTime + LEFT_SIGNAL_TIME, n->getID()));
+        if (n->leftTurnSignalOn()) timers.schedule(n->getIndex(), currentTime + LEFT_SIGNAL_TIME);
+        G->markIntersection(n);
     }
-    // get current cycle number in intersection, if green, check if net flow is less than 2 times the opposite flow
-    // if so, then cycle the lights
-    for (pair<int, Intersection*> n : G->getIntersections()) {
-        if (currentTime - n.second->getTimeOfLastCycle() < MIN_TIME || n.second->leftTurnSignalOn()) continue;
-        else if (currentTime - n.second->getTimeOfLastCycle() >= MAX_TIME && n.second->getOppositeFlow() != 0) events.push(make_pair(currentTime + COOLDOWN, n.first));
-        else if (n.second->getCurrentFlow() < 2 * n.second->getOppositeFlow()) events.push(make_pair(currentTime + COOLDOWN, n.first));
+    while (!deadlines.empty() && deadlines.getNextTime() <= currentTime) {
+        G->markIntersection(G->getCompiled()->getIntersection(deadlines.pop()));
     }
+    vector<Intersection*> &marked = G->getMarkedIntersections();
+    for (Intersection *n : marked) {
+        n->setMarked(false);
+        check(n, currentTime);
+    }
+    marked.clear();
+}
+
+/**
+ * Checks whether an intersection should cycle, and sets the deadline at which it has to be checked again if its
+ * demand does not change. If the light is green, the net flow is compared to 2 times the opposite flow, and
+ * if it is less, then the lights are cycled.
+ * @param n the intersection
+ * @param currentTime the current time
+ */
+void BasicController::check(Intersection *n, double currentTime) {
+    if (n->leftTurnSignalOn()) return; // the left signal has a pending event, which checks the intersection again
+    double sinceCycle = currentTime - n->getTimeOfLastCycle();
+    if (sinceCycle < MIN_TIME) {
+        deadlines.schedule(n->getIndex(), n->getTimeOfLastCycle() + MIN_TIME);
+        return;
+    }
+    if (sinceCycle >= MAX_TIME && n->getOppositeFlow() != 0) timers.scheduleBefore(n->getIndex(), currentTime + COOLDOWN);
+    else if (n->getCurrentFlow() < 2 * n->getOppositeFlow()) timers.scheduleBefore(n->getIndex(), currentTime + COOLDOWN);
+    if (sinceCycle < MAX_TIME) deadlines.schedule(n->getIndex(), n->getTimeOfLastCycle() + MAX_TIME);
 }
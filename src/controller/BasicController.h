@@ -9,6 +9,11 @@
 #define LEFT_SIGNAL_TIME 20
 #define COOLDOWN 5
 struct BasicController : public Controller {
+private:
+    TimerQueue deadlines; // the next time each intersection passes MIN_TIME or MAX_TIME since its last cycle
+
+    void check(Intersection *n, double currentTime);
+
 public:
     BasicController(WeightedDigraph *G);
     ~BasicController();
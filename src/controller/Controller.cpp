@@ -1,5 +1,7 @@
 #include "Controller.h"
 
+using namespace std;
+
 /**
  * Initializes the Controller given a Weighted Directed Graph.
  * @param G the Weighted Directed Graph that the controller will control
@@ -17,3 +19,24 @@ Controller::~Controller() {}
  * Returns a pointer to the weighted directed graph.
  */
 WeightedDigraph *Controller::getGraph() const { return G; }
+
+/**
+ * Returns the time of the next scheduled event, or infinity if there are no events.
+ */
+double Controller::getNextEventTime() const { return timers.getNextTime(); }
+
+/**
+ * Returns the timers of the intersections, which count the operations done on them.
+ */
+const TimerQueue &Controller::getTimers() const { return timers; }
+
+/**
+ * Clears the marked intersections of the graph, for controllers whose decisions do not depend on the changes in demand.
+ */
+void Controller::unmarkIntersections() {
+    vector<Intersection*> &marked = G->getMarkedIntersections();
+    for (Intersection *n : marked) {
+        n->setMarked(false);
+    }
+    marked.clear();
+}
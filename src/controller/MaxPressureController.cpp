@@ -0,0 +1,87 @@
+#include <assert.h>
+#include "MaxPressureController.h"
+
+using namespace std;
+
+/**
+ * Initializes the MaxPressureController given a Weighted Directed Graph.
+ * @param G the Weighted Directed Graph that the controller will control
+ */
+MaxPressureController::MaxPressureController(WeightedDigraph *G) : Controller(G) {}
+
+/**
+ * Deconstructs the MaxPressureController.
+ */
+MaxPressureController::~MaxPressureController() {}
+
+/**
+ * Adds an event with a specified intersection ID at a specified time, replacing the pending event of the intersection.
+ * The event is when the intersection next decides its phase.
+ * @param time the specified time the event will occur
+ * @param id the intersection ID of the event
+ */
+void MaxPressureController::addEvent(double time, int id) {
+    G->getCompiled(); // the intersections get their indices
+    timers.schedule(G->getIntersection(id)->getIndex(), time);
+}
+
+/**
+ * Returns true if the current time is at or after the time the next event is scheduled to occur.
+ * Returns false otherwise.
+ * @param currentTime the current time
+ */
+bool MaxPressureController::checkNextEvent(double currentTime) const {
+    return currentTime >= timers.getNextTime();
+}
+
+/**
+ * Runs the events that are before or at the current time that have not yet been run, and schedules the next
+ * decision of each intersection that decided.
+ * @param currentTime the current time
+ */
+void MaxPressureController::runEvents(double currentTime) {
+    while (!timers.empty() && timers.getNextTime() <= currentTime) {
+        Intersection *n = G->getCompiled()->getIntersection(timers.pop());
+        decide(n, currentTime);
+        timers.schedule(n->getIndex(), currentTime + PRESSURE_PERIOD);
+    }
+    unmarkIntersections(); // the queues are read when deciding
+}
+
+/**
+ * Turns on the phase of an intersection with the largest pressure. The pressure of each movement is found once,
+ * and each phase adds up the pressures of its movements. Cars queue in a single lane, so the queue of a road can only
+ * leave by the movement its first car takes. That movement has the whole queue upstream, and the other movements
+ * from the road have no pressure, since serving them would not move any car.
+ * @param n the intersection
+ * @param currentTime the current time
+ */
+void MaxPressureController::decide(Intersection *n, double currentTime) {
+    if (n->countPhases() == 0) return;
+    const vector<TrafficLight*> &movements = n->getMovements();
+    pressure.resize(movements.size());
+    for (int m = 0; m < (int) movements.size(); m++) {
+        RoadSegment *from = movements[m]->getFrom(), *to = movements[m]->getTo();
+        Car *first = from->countCarsInQueue() > 0 ? from->getNextCarFromQueue() : nullptr;
+        pressure[m] = first != nullptr && first->hasNextRoad() && first->peekNextRoad() == to ? from->countCarsInQueue() - to->getFlow() : 0;
+    }
+    int best = n->getCurrentPhase();
+    int bestPressure = 0;
+    if (best != -1) {
+        for (int m : n->getPhaseMovements(best)) {
+            bestPressure += pressure[m];
+        }
+    }
+    for (int p = 0; p < n->countPhases(); p++) {
+        if (p == n->getCurrentPhase() || !n->hasPhase(p)) continue;
+        int total = 0;
+        for (int m : n->getPhaseMovements(p)) {
+            total += pressure[m];
+        }
+        if (best == -1 || total > bestPressure) {
+            best = p;
+            bestPressure = total;
+        }
+    }
+    if (best != n->getCurrentPhase()) n->setPhase(best, currentTime);
+}
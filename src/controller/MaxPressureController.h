@@ -0,0 +1,30 @@
+#ifndef MAXPRESSURECONTROLLER_H_
+#define MAXPRESSURECONTROLLER_H_
+
+#include <vector>
+#include "../framework/Framework.h"
+#include "Controller.h"
+
+#define PRESSURE_PERIOD 5 // the seconds between the decisions of an intersection, which is also the shortest phase
+
+/**
+ * Max-pressure signal control. Every PRESSURE_PERIOD seconds, each intersection turns on the phase with the largest
+ * pressure, which is the sum over the movements of the phase of the cars queued for the movement on the road it leads
+ * from minus the cars on the road it leads to. The current phase is kept unless another phase has a larger pressure.
+ * A decision visits each movement of the intersection a constant number of times.
+ */
+struct MaxPressureController : public Controller {
+private:
+    std::vector<int> pressure; // the pressure of each movement of the intersection being decided
+
+    void decide(Intersection *n, double currentTime);
+
+public:
+    MaxPressureController(WeightedDigraph *G);
+    ~MaxPressureController();
+    void addEvent(double time, int id);
+    bool checkNextEvent(double currentTime) const;
+    void runEvents(double currentTime);
+};
+
+#endif
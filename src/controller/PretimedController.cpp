@@ -15,13 +15,14 @@ PretimedController::PretimedController(WeightedDigraph *G) : Controller(G) {}
 PretimedController::~PretimedController() {}
 
 /**
- * Adds an event with a specified intersection ID at a specified time.
+ * Adds an event with a specified intersection ID at a specified time, replacing the pending event of the intersection.
  * The event is when the traffic signal is scheduled to be cycled.
  * @param time the specified time the event will occur
  * @param id the intersection ID of the event
  */
 void PretimedController::addEvent(double time, int id) {
-    events.push(make_pair(time, id));
+    G->getCompiled(); // the intersections get their indices
+    timers.schedule(G->getIntersection(id)->getIndex(), time);
 }
 
 /**
@@ -30,7 +31,7 @@ void PretimedController::addEvent(double time, int id) {
  * @param currentTime the current time
  */
 bool PretimedController::checkNextEvent(double currentTime) const {
-    return currentTime >= events.top().first;
+    return currentTime >= timers.getNextTime();
 }
 
 /**
@@ -39,12 +40,12 @@ bool PretimedController::checkNextEvent(double currentTime) const {
  * @param currentTime the current time
  */
 void PretimedController::runEvents(double currentTime) {
-    while (!events.empty() && events.top().first <= currentTime) {
-        Intersection *n = G->getIntersection(events.top().second);
+    while (!timers.empty() && timers.getNextTime() <= currentTime) {
+        Intersection *n = G->getCompiled()->getIntersection(timers.pop());
         bool prevLeft = n->leftTurnSignalOn();
-        events.pop();
         n->cycle(currentTime);
-        if (n->leftTurnSignalOn()) events.push(make_pair(currentTime + 10.0, n->getID())); // 10 seconds for left signals
-        else events.push(make_pair(currentTime + 30.0 - (10.0 * prevLeft), n->getID())); // 20 seconds if there was just a left signal, 30 otherwise
+        if (n->leftTurnSignalOn()) timers.schedule(n->getIndex(), currentTime + LEFT_PHASE_TIME); // 10 seconds for left signals
+        else timers.schedule(n->getIndex(), currentTime + STRAIGHT_PHASE_TIME - (LEFT_PHASE_TIME * prevLeft)); // 20 seconds if there was just a left signal, 30 otherwise
     }
+    unmarkIntersections(); // the timings do not depend on the demand
 }
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <assert.h>
+#include "CSRGraph.h"
+#include "WeightedDigraph.h"
+
+using namespace std;
+
+/**
+ * Compiles a Weighted Directed Graph and gives each of its intersections and road segments a dense index.
+ * @param G the Weighted Directed Graph
+ */
+CSRGraph::CSRGraph(WeightedDigraph *G) {
+    for (pair<int, Intersection*> n : G->getIntersections()) {
+        intersections.push_back(n.second);
+    }
+    for (pair<int, RoadSegment*> r : G->getRoadSegments()) {
+        roads.push_back(r.second);
+    }
+    // sorting by ID makes the indices independent of the order of the hash maps
+    sort(intersections.begin(), intersections.end(), [](Intersection *a, Intersection *b) { return a->getID() < b->getID(); });
+    sort(roads.begin(), roads.end(), [](RoadSegment *a, RoadSegment *b) { return a->getID() < b->getID(); });
+    int n = intersections.size(), m = roads.size();
+    for (int v = 0; v < n; v++) {
+        intersections[v]->setIndex(v);
+    }
+    outStart.assign(n + 1, 0);
+    inStart.assign(n + 1, 0);
+    for (int e = 0; e < m; e++) {
+        RoadSegment *r = roads[e];
+        r->setIndex(e);
+        source.push_back(r->getSource()->getIndex());
+        destination.push_back(r->getDestination()->getIndex());
+        length.push_back(r->getLength());
+        speedLimit.push_back(r->getSpeedLimit());
+        expectedTime.push_back(r->getExpectedTime());
+        capacity.push_back(r->getCapacity());
+        outStart[source[e] + 1]++;
+        inStart[destination[e] + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+        outStart[v + 1] += outStart[v];
+        inStart[v + 1] += inStart[v];
+    }
+    outRoads.resize(m);
+    inRoads.resize(m);
+    vector<int> outNext(outStart.begin(), outStart.end() - 1), inNext(inStart.begin(), inStart.end() - 1);
+    for (int e = 0; e < m; e++) { // road segments are visited in order of index, so each group is sorted
+        outRoads[outNext[source[e]]++] = e;
+        inRoads[inNext[destination[e]]++] = e;
+    }
+}
+
+/**
+ * Deconstructs the compiled graph. The intersections and road segments are not deleted.
+ */
+CSRGraph::~CSRGraph() {}
+
+/**
+ * Returns the number of intersections (vertices).
+ */
+int CSRGraph::countIntersections() const { return intersections.size(); }
+
+/**
+ * Returns the number of road segments (edges).
+ */
+int CSRGraph::countRoadSegments() const { return roads.size(); }
+
+/**
+ * Returns a pointer to the intersection with the specified index.
+ * @param v the index of the intersection
+ */
+Intersection *CSRGraph::getIntersection(int v) const {
+    assert(v >= 0 && v < (int) intersections.size() && "the index must statisfy 0 <= index < number of intersections");
+    return intersections[v];
+}
+
+/**
+ * Returns a pointer to the road segment with the specified index.
+ * @param e the index of the road segment
+ */
+RoadSegment *CSRGraph::getRoadSegment(int e) const {
+    assert(e >= 0 && e < (int) roads.size() && "the index must statisfy 0 <= index < number of road segments");
+    return roads[e];
+}
+
+/**
+ * Returns an immutable reference to the intersections, indexed by intersection.
+ */
+const vector<Intersection*> &CSRGraph::getIntersections() const { return intersections; }
+
+/**
+ * Returns an immutable reference to the road segments, indexed by road segment.
+ */
+const vector<RoadSegment*> &CSRGraph::getRoadSegments() const { return roads; }
+
+/**
+ * Returns an immutable reference to the start of the outbound road segments of each intersection in getOutRoads().
+ * There is one more entry than there are intersections.
+ */
+const vector<int> &CSRGraph::getOutStart() const { return outStart; }
+
+/**
+ * Returns an immutable reference to the indices of the outbound road segments, grouped by source intersection.
+ */
+const vector<int> &CSRGraph::getOutRoads() const { return outRoads; }
+
+/**
+ * Returns an immutable reference to the start of the inbound road segments of each intersection in getInRoads().
+ * There is one more entry than there are intersections.
+ */
+const vector<int> &CSRGraph::getInStart() const { return inStart; }
+
+/**
+ * Returns an immutable reference to the indices of the inbound road segments, grouped by destination intersection.
+ */
+const vector<int> &CSRGraph::getInRoads() const { return inRoads; }
+
+/**
+ * Returns an immutable reference to the index of the source intersection of each road segment.
+ */
+const vector<int> &CSRGraph::getSources() const { return source; }
+
+/**
+ * Returns an immutable reference to the index of the destination intersection of each road segment.
+ */
+const vector<int> &CSRGraph::getDestinations() const { return destination; }
+
+/**
+ * Returns an immutable reference to the length of each road segment.
+ */
+const vector<double> &CSRGraph::getLengths() const { return length; }
+
+/**
+ * Returns an immutable reference to the speed limit of each road segment.
+ */
+const vector<double> &CSRGraph::getSpeedLimits() const { return speedLimit; }
+
+/**
+ * Returns an immutable reference to the time to travel each road segment at the speed limit.
+ */
+const vector<double> &CSRGraph::getExpectedTimes() const { return expectedTime; }
+
+/**
+ * Returns an immutable reference to the capacity of each road segment.
+ */
+const vector<int> &CSRGraph::getCapacities() const { return capacity; }
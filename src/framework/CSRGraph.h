@@ -0,0 +1,49 @@
+#ifndef CSRGRAPH_H_
+#define CSRGRAPH_H_
+
+#include <vector>
+#include "Forward.h"
+
+/**
+ * An immutable compressed sparse row form of a Weighted Directed Graph. Intersections and road segments get dense
+ * indices 0..N-1 (in order of ID), the outbound and inbound road segments of each intersection are contiguous,
+ * and the attributes of the road segments are kept in parallel arrays, so the network can be traversed without hashing.
+ * It is rebuilt by WeightedDigraph::getCompiled() after the network changes.
+ */
+struct CSRGraph {
+private:
+    std::vector<Intersection*> intersections; // the intersection with each index
+    std::vector<RoadSegment*> roads; // the road segment with each index
+    std::vector<int> outStart; // the outbound road segments of intersection v are outRoads[outStart[v]..outStart[v + 1])
+    std::vector<int> outRoads; // the indices of the outbound road segments, grouped by source intersection
+    std::vector<int> inStart; // the inbound road segments of intersection v are inRoads[inStart[v]..inStart[v + 1])
+    std::vector<int> inRoads; // the indices of the inbound road segments, grouped by destination intersection
+    std::vector<int> source; // the index of the source intersection of each road segment
+    std::vector<int> destination; // the index of the destination intersection of each road segment
+    std::vector<double> length; // the length of each road segment
+    std::vector<double> speedLimit; // the speed limit of each road segment
+    std::vector<double> expectedTime; // the time to travel each road segment at the speed limit
+    std::vector<int> capacity; // the capacity of each road segment
+
+public:
+    CSRGraph(WeightedDigraph *G);
+    ~CSRGraph();
+    int countIntersections() const;
+    int countRoadSegments() const;
+    Intersection *getIntersection(int v) const;
+    RoadSegment *getRoadSegment(int e) const;
+    const std::vector<Intersection*> &getIntersections() const;
+    const std::vector<RoadSegment*> &getRoadSegments() const;
+    const std::vector<int> &getOutStart() const;
+    const std::vector<int> &getOutRoads() const;
+    const std::vector<int> &getInStart() const;
+    const std::vector<int> &getInRoads() const;
+    const std::vector<int> &getSources() const;
+    const std::vector<int> &getDestinations() const;
+    const std::vector<double> &getLengths() const;
+    const std::vector<double> &getSpeedLimits() const;
+    const std::vector<double> &getExpectedTimes() const;
+    const std::vector<int> &getCapacities() const;
+};
+
+#endif
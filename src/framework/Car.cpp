@@ -1,15 +1,31 @@
+#include <algorithm>
 #include <cstdlib>
 #include <cmath>
 #include <ctime>
 #include <limits>
 #include <assert.h>
 #include "Car.h"
+#include "SimulationContext.h"
 
 using namespace std;
 
-int Car::counter = 0; // counter starts at 0
-double Car::efficiency = 1.0;
-int Car::reached = 0;
+/**
+ * Returns the time at the speed limit from a point on a road segment to the end of it.
+ * @param r the road segment
+ * @param location the point
+ */
+static double timeToEnd(RoadSegment *r, Point2D &location) {
+    return r->getDestination()->getLocation().distanceTo(location) / r->getLength() * r->getExpectedTime();
+}
+
+/**
+ * Returns the time at the speed limit from the start of a road segment to a point on it.
+ * @param r the road segment
+ * @param location the point
+ */
+static double timeFromStart(RoadSegment *r, Point2D &location) {
+    return r->getSource()->getLocation().distanceTo(location) / r->getLength() * r->getExpectedTime();
+}
 
 /**
  * Initializes a car given the starting and ending point.
@@ -19,31 +35,67 @@ int Car::reached = 0;
  * @param destinationRoads the road segments that lead into the destination
  * @param currentTime the current time in the simulation
  * @param G the Weighted Directed Graph
+ * @param path the path found in advance for the car, which the car takes ownership of and deletes once its route is interned, nullptr to find it here
  */
-Car::Car(Point2D &source, Point2D &destination, vector<RoadSegment*> &sourceRoads, vector<RoadSegment*> &destinationRoads, double currentTime, WeightedDigraph *G) {
-    this->source = source;
-    this->destination = destination;
-    this->sourceRoads = sourceRoads;
-    this->destinationRoads = destinationRoads;
-    this->expectedTime = 0.0;
-    id = counter++;
+Car::Car(Point2D &source, Point2D &destination, vector<RoadSegment*> &sourceRoads, vector<RoadSegment*> &destinationRoads, double currentTime, WeightedDigraph *G, DijkstraDirectedSP *path) {
+    double expectedTime = 0.0;
+    shared_ptr<const Route> route;
+    shared_ptr<const RoutingTable> table;
+    id = G->getContext()->nextCarID();
+    store = G->getCarStore();
+    handle = store->allocate(this);
+    vector<int> sourceIntersections, destinationIntersections; // IDs of possible source and destination intersections
+    vector<double> initialTime, excessTime; // the time to each possible source intersection, and from each possible destination intersection
     for (RoadSegment *r : sourceRoads) {
         assert(r->getCapacity() - r->getFlow() >= 1);
         sourceIntersections.push_back(r->getDestination()->getID());
-        initialTime.push_back(r->getDestination()->getLocation().distanceTo(this->source) / r->getLength() * r->getExpectedTime());
+        initialTime.push_back(timeToEnd(r, source));
     }
     for (RoadSegment *r : destinationRoads) {
         destinationIntersections.push_back(r->getSource()->getID());
-        excessTime.push_back(r->getSource()->getLocation().distanceTo(this->destination) / r->getLength() * r->getExpectedTime());
+        excessTime.push_back(timeFromStart(r, destination));
     }
-    path = new DijkstraDirectedSP(G, sourceIntersections, initialTime, destinationIntersections, excessTime);
-    assert(path->hasPath() && "there is no path for the car to reach the destination from the source");
-    for (RoadSegment *r : path->getShortestPath()) {
-        expectedTime += r->getExpectedTime();
+    int pathSourceID, pathDestinationID;
+    if (path == nullptr && (G->getRoutingMode() == ROUTING_TABLES || G->getRoutingMode() == ROUTING_LIVE)) {
+        pathSourceID = pathDestinationID = -1;
+        double shortestTime = numeric_limits<double>::infinity();
+        for (int d = 0; d < (int) destinationIntersections.size(); d++) {
+            shared_ptr<const RoutingTable> t = G->getRoutingTables()->get(G->getIntersection(destinationIntersections[d])->getIndex());
+            for (int s = 0; s < (int) sourceIntersections.size(); s++) {
+                double time = initialTime[s] + t->getTimeLeft(G->getIntersection(sourceIntersections[s])->getIndex()) + excessTime[d];
+                if (time < shortestTime) {
+                    shortestTime = time;
+                    table = t;
+                    pathSourceID = sourceIntersections[s];
+                    pathDestinationID = destinationIntersections[d];
+                }
+            }
+        }
+        assert(table != nullptr && "there is no path for the car to reach the destination from the source");
+        if (G->getRoutingMode() == ROUTING_LIVE) { // the time left includes congestion, so the route is timed at the speed limits
+            for (Intersection *v = G->getIntersection(pathSourceID); v != table->getDestination(); v = table->getNextRoad(v->getIndex())->getDestination()) {
+                expectedTime += table->getNextRoad(v->getIndex())->getExpectedTime();
+            }
+        } else {
+            expectedTime += table->getTimeLeft(G->getIntersection(pathSourceID)->getIndex());
+        }
+    } else {
+        if (path == nullptr && (G->getRoutingMode() == ROUTING_TURNS || G->getRoutingMode() == ROUTING_SIGNALS)) path = new DijkstraDirectedSP(G, sourceRoads, initialTime, destinationRoads, excessTime, currentTime);
+        else if (path == nullptr) path = new DijkstraDirectedSP(G, sourceIntersections, initialTime, destinationIntersections, excessTime);
+        assert(path->hasPath() && "there is no path for the car to reach the destination from the source");
+        for (RoadSegment *r : path->getShortestPath()) {
+            expectedTime += r->getExpectedTime();
+        }
+        pathSourceID = path->getSourceID();
+        pathDestinationID = path->getDestinationID();
+        route = G->getRoutes()->intern(path->getShortestPath());
+        delete path; // the car only keeps the interned route
     }
-    currentLocation = this->source;
+    RoadSegment *currentRoad = nullptr;
+    RoadSegment *finalRoad = nullptr;
+    double destinationPosition = 0.0;
     for (RoadSegment *r : sourceRoads) {
-        if (r->getDestination()->getID() == path->getSourceID()) {
+        if (r->getDestination()->getID() == pathSourceID) {
             currentRoad = r;
             expectedTime += currentRoad->getDestination()->getLocation().distanceTo(source) / currentRoad->getSpeedLimit();
             break;
@@ -51,17 +103,23 @@ Car::Car(Point2D &source, Point2D &destination, vector<RoadSegment*> &sourceRoad
     }
     assert(currentRoad != nullptr);
     for (RoadSegment *r : destinationRoads) {
-        if (r->getSource()->getID() == path->getDestinationID()) {
+        if (r->getSource()->getID() == pathDestinationID) {
             finalRoad = r;
-            expectedTime += finalRoad->getSource()->getLocation().distanceTo(destination) / finalRoad->getSpeedLimit();
+            destinationPosition = finalRoad->getSource()->getLocation().distanceTo(destination);
+            expectedTime += destinationPosition / finalRoad->getSpeedLimit();
             break;
         }
     }
     assert(finalRoad != nullptr);
-    pathIndex = -1;
+    store->getFinalRoads()[handle.index] = finalRoad;
+    store->getFinalPositions()[handle.index] = destinationPosition;
+    store->getRoutes()[handle.index] = route;
+    store->getTables()[handle.index] = table;
+    store->getStartTimes()[handle.index] = currentTime;
+    store->getExpectedTimes()[handle.index] = expectedTime;
+    store->getNextRoads()[handle.index] = route != nullptr || currentRoad == finalRoad ? nullptr : lookUpNextRoad(currentRoad);
     currentRoad->addIncoming(this);
-    assert(currentRoad->addCar(this));
-    this->startTime = currentTime;
+    assert(currentRoad->addCar(this, currentRoad->getSource()->getLocation().distanceTo(source)));
 }
 
 /**
@@ -69,41 +127,48 @@ Car::Car(Point2D &source, Point2D &destination, vector<RoadSegment*> &sourceRoad
  */
 int Car::getID() const { return id; }
 
+/**
+ * Returns the handle of the car's slot in the car store.
+ */
+CarHandle Car::getHandle() const { return handle; }
+
 /**
  * Returns the time elapsed in the car's jouney so far.
  */
-double Car::getElapsedTime(double currentTime) const { return currentTime - startTime; }
+double Car::getElapsedTime(double currentTime) const { return currentTime - store->getStartTimes()[handle.index]; }
 
 /**
  * Returns the time expected for the car to complete its journey assuming no traffic.
  */
-double Car::getExpectedTime() const { return expectedTime; }
+double Car::getExpectedTime() const { return store->getExpectedTimes()[handle.index]; }
 
 /**
  * Returns the car's current speed.
  */
-double Car::getCurrentSpeed() const { return currentSpeed; }
+double Car::getCurrentSpeed() const { return store->getSpeeds()[handle.index]; }
 
 /**
  * Sets the car's speed.
  */
-void Car::setSpeed(double speed) { currentSpeed = speed; }
+void Car::setSpeed(double speed) { store->getSpeeds()[handle.index] = speed; }
 
 /**
  * Returns the road the car is currently on.
  */
-RoadSegment *Car::getCurrentRoad() const { return currentRoad; }
+RoadSegment *Car::getCurrentRoad() const { return store->getRoads()[handle.index]; }
 
 /**
  * Returns the final road the car will travel on.
  */
-RoadSegment *Car::getFinalRoad() const { return finalRoad; }
+RoadSegment *Car::getFinalRoad() const { return store->getFinalRoads()[handle.index]; }
 
 /**
  * Returns true if the car has another road on its path, false otherwise.
  */
 bool Car::hasNextRoad() const {
-    return pathIndex + 1 <= path->getShortestPath().size();
+    const Route *route = store->getRoutes()[handle.index].get();
+    if (route == nullptr) return store->getNextRoads()[handle.index] != nullptr;
+    return store->getPathIndices()[handle.index] + 1 <= route->size();
 }
 
 /**
@@ -112,81 +177,93 @@ bool Car::hasNextRoad() const {
 RoadSegment *Car::getNextRoad() {
     assert(hasNextRoad() && "car does not have another road on its path");
     RoadSegment *r = peekNextRoad();
-    pathIndex++;
+    store->getPathIndices()[handle.index]++;
+    if (store->getRoutes()[handle.index] == nullptr) store->getNextRoads()[handle.index] = r == getFinalRoad() ? nullptr : lookUpNextRoad(r);
     return r;
 }
 
 /**
- * Returns the next road on the car's path.
+ * Returns the next road on the car's path. A car that follows a routing table chose its next road when it entered
+ * the road before it, so the road it is expected on does not change if the table is refreshed in the meantime.
  */
 RoadSegment *Car::peekNextRoad() const {
     assert(hasNextRoad() && "car does not have another road on its path");
-    return pathIndex + 1 < path->getShortestPath().size() ? path->getShortestPath()[pathIndex + 1] : finalRoad;
+    const Route *route = store->getRoutes()[handle.index].get();
+    if (route == nullptr) return store->getNextRoads()[handle.index];
+    int pathIndex = store->getPathIndices()[handle.index];
+    return pathIndex + 1 < route->size() ? route->getRoad(pathIndex + 1) : getFinalRoad();
 }
 
 /**
- * Sets the road the car is on.
+ * Looks up the road a car that follows a routing table takes after a road segment.
+ * @param r the road segment, which is not the final road
  */
-void Car::setRoad(RoadSegment *road) { currentRoad = road; }
+RoadSegment *Car::lookUpNextRoad(RoadSegment *r) const {
+    Intersection *v = r->getDestination();
+    const RoutingTable *table = store->getTables()[handle.index].get();
+    return v == table->getDestination() ? getFinalRoad() : table->getNextRoad(v->getIndex());
+}
 
 /**
- * Returns the car's current location.
+ * Sets the road the car is on, and the position where the car will leave it.
  */
-Point2D Car::getCurrentLocation() const { return currentLocation; }
+void Car::setRoad(RoadSegment *road) {
+    store->getRoads()[handle.index] = road;
+    if (road != nullptr) store->getTargets()[handle.index] = hasNextRoad() ? road->getLength() : store->getFinalPositions()[handle.index];
+}
 
 /**
- * Sets the car's location.
+ * Returns the distance the car has travelled along its current road.
  */
-void Car::setLocation(Point2D &location) { currentLocation = location; }
+double Car::getPosition() const { return store->getPositions()[handle.index]; }
 
 /**
- * Returns the car's source location.
+ * Returns the car's current location. The location is computed from the car's position along its road.
  */
-Point2D Car::getSource() const { return source; }
+Point2D Car::getCurrentLocation() const {
+    RoadSegment *road = getCurrentRoad();
+    return road != nullptr ? road->getLocationAt(getPosition()) : getDestination();
+}
 
 /**
- * Returns the car's destination location.
+ * Returns the car's destination location, which is found from its position on the final road.
  */
-Point2D Car::getDestination() const { return destination; }
+Point2D Car::getDestination() const { return getFinalRoad()->getLocationAt(store->getFinalPositions()[handle.index]); }
 
 /**
- * Deconstructs the Car and updates the efficiency
+ * Deconstructs the Car. Cars should only be deleted by the car store once their slot is released.
  */
-Car::~Car() {
-    delete path;
-}
+Car::~Car() {}
 
 /**
- * Updates the efficiency of the car.
+ * Adds the efficiency of the car to the statistics of its context.
  * @param endTime the time the car reached the destination.
  */
 void Car::updateEfficiency(double endTime) {
     assert(!hasNextRoad() && "car has not reached its destination");
-    efficiency = ((efficiency * reached) + (expectedTime / (endTime - startTime))) / (reached + 1);
-    reached++;
+    getFinalRoad()->getSource()->getContext()->recordArrival(getExpectedTime() / (endTime - store->getStartTimes()[handle.index]));
 }
 
 /**
- * Returns the efficiency of all cars.
- */
-double Car::getEfficiency() { return efficiency; }
-
-/**
- * Returns a random road segment in the graph.
+ * Returns a random road segment in the graph with room for another car, drawn from the spawn stream of the graph.
+ * @param G the Weighted Directed Graph
+ * @param reserved the number of cars that will be placed on each road segment by index, which also take up room
+ * @return the road segment, or nullptr if none of ROAD_ATTEMPTS draws had room
  */
-RoadSegment *getRandomRoadSegment(WeightedDigraph *G) {
-    while (true) {
-        int randIndex = rand() % G->countRoadSegments();
-        RoadSegment *r = G->getRoadSegment(G->getRoadSegmentID(randIndex));
-        if (r->getCapacity() - r->getFlow() >= 1) return r;
+RoadSegment *getRandomRoadSegment(WeightedDigraph *G, const vector<int> &reserved) {
+    for (int k = 0; k < ROAD_ATTEMPTS; k++) {
+        int randIndex = G->getSpawnRandom().nextInt(G->countRoadSegments());
+        RoadSegment *r = G->getCompiled()->getRoadSegment(randIndex);
+        if (r->getCapacity() - r->getFlow() - reserved[randIndex] >= 1) return r;
     }
+    return nullptr;
 }
 
 /**
- * Returns a random point on the road segment.
+ * Returns a random point on the road segment, drawn from the spawn stream of its graph.
  */
 Point2D getRandomLocation(RoadSegment *r) {
-    double randDist = r->getLength() * rand() / RAND_MAX;
+    double randDist = r->getLength() * r->getGraph()->getSpawnRandom().nextDouble();
     Point2D srcLoc = r->getSource()->getLocation(), destLoc = r->getDestination()->getLocation();
     double angle = srcLoc.angleTo(destLoc);
     double dx = randDist * cos(angle);
@@ -195,19 +272,130 @@ Point2D getRandomLocation(RoadSegment *r) {
 }
 
 /**
- * Returns a car with a randomly generated source and destination.
- * MAKE SURE THAT RAND HAS A SEED
+ * Returns trips with a randomly generated source and destination, drawn from the spawn stream of the graph.
+ * Each trip takes up room on its source road for the trips after it, so the trips are the same as those of cars
+ * created one at a time with getRandomCar(). Destinations that cannot be reached from the source are drawn again
+ * before any route is searched, and the source is drawn again if TRIP_ATTEMPTS destinations in a row cannot be used.
+ * If no trip is found from TRIP_SOURCES sources, or the roads are full, the trip and the rest of the trips are given
+ * up, so fewer than n trips may be returned.
+ * @param G the Weighted Directed Graph
+ * @param n the number of trips
+ */
+vector<Trip> getRandomTrips(WeightedDigraph *G, int n) {
+    vector<int> reserved(G->countRoadSegments(), 0);
+    vector<Trip> trips;
+    for (int i = 0; i < n; i++) {
+        RoadSegment *src = nullptr, *dest = nullptr;
+        for (int s = 0; s < TRIP_SOURCES && dest == nullptr; s++) {
+            src = getRandomRoadSegment(G, reserved);
+            if (src == nullptr) break;
+            for (int k = 0; k < TRIP_ATTEMPTS && dest == nullptr; k++) {
+                dest = getRandomRoadSegment(G, reserved);
+                if (dest == nullptr) break;
+                if (src->getID() == dest->getID() || src->getDestination()->getID() == dest->getSource()->getID() || src->getSource()->getID() == dest->getDestination()->getID()
+                        || !G->isReachable(src->getDestination(), dest->getSource())) dest = nullptr;
+            }
+        }
+        if (dest == nullptr) break; // the roads are full or no trip can be driven, so the later trips would fail too
+        Point2D srcLoc = getRandomLocation(src);
+        Point2D destLoc = getRandomLocation(dest);
+        reserved[src->getIndex()]++;
+        trips.push_back({src, dest, srcLoc, destLoc});
+    }
+    return trips;
+}
+
+/**
+ * Returns a car with a randomly generated source and destination, or nullptr if no trip could be found.
+ * The choices are drawn from the spawn stream of the graph, so they only depend on the seed of the graph.
  */
 Car *getRandomCar(WeightedDigraph *G, double currentTime) {
-    RoadSegment *src = getRandomRoadSegment(G);
-    RoadSegment *dest = nullptr;
-    do {
-        dest = getRandomRoadSegment(G);
-    } while (src->getID() == dest->getID() || src->getDestination()->getID() == dest->getSource()->getID() || src->getSource()->getID() == dest->getDestination()->getID());
-    vector<RoadSegment*> sourceRoads, destinationRoads;
-    sourceRoads.push_back(src);
-    destinationRoads.push_back(dest);
-    Point2D srcLoc = getRandomLocation(src);
-    Point2D destLoc = getRandomLocation(dest);
-    return new Car(srcLoc, destLoc, sourceRoads, destinationRoads, currentTime, G);
+    vector<Trip> trips = getRandomTrips(G, 1);
+    if (trips.empty()) return nullptr;
+    Trip t = trips[0];
+    vector<RoadSegment*> sourceRoads(1, t.sourceRoad), destinationRoads(1, t.destinationRoad);
+    return new Car(t.source, t.destination, sourceRoads, destinationRoads, currentTime, G);
+}
+
+/**
+ * Creates the cars of many trips at once. The routes are found in parallel first, and the cars are then created and
+ * placed on their roads in order, so the result does not depend on the number of threads.
+ * With Dijkstra's algorithm, the trips are grouped by source intersection and each group is routed by one search
+ * that stops once all of its destinations are settled. With routing tables, the table of each destination is built
+ * in parallel. Otherwise each trip is routed on its own.
+ * @param G the Weighted Directed Graph
+ * @param trips the trips
+ * @param currentTime the current time in the simulation
+ * @param pool the threads used to find the routes
+ * @return the cars in the order of their trips
+ */
+vector<Car*> createCars(WeightedDigraph *G, vector<Trip> &trips, double currentTime, ThreadPool *pool) {
+    G->getCompiled(); // the lazily built structures are built before the workers use them
+    vector<DijkstraDirectedSP*> paths(trips.size(), nullptr);
+    if (G->getRoutingMode() == ROUTING_DIJKSTRA) {
+        vector<int> order(trips.size()); // the trips sorted by source intersection
+        for (int i = 0; i < (int) trips.size(); i++) {
+            order[i] = i;
+        }
+        stable_sort(order.begin(), order.end(), [&](int a, int b) { return trips[a].sourceRoad->getDestination()->getIndex() < trips[b].sourceRoad->getDestination()->getIndex(); });
+        vector<int> groupStart; // the trips of group g are order[groupStart[g]..groupStart[g + 1])
+        for (int i = 0; i < (int) order.size(); i++) {
+            if (i == 0 || trips[order[i]].sourceRoad->getDestination() != trips[order[i - 1]].sourceRoad->getDestination()) groupStart.push_back(i);
+        }
+        groupStart.push_back(order.size());
+        pool->parallelFor(groupStart.size() - 1, 1, [&](int begin, int end) {
+            for (int g = begin; g < end; g++) {
+                vector<double> initialTime, excessTime;
+                vector<int> destinationIDs;
+                for (int i = groupStart[g]; i < groupStart[g + 1]; i++) {
+                    Trip &t = trips[order[i]];
+                    initialTime.push_back(timeToEnd(t.sourceRoad, t.source));
+                    destinationIDs.push_back(t.destinationRoad->getSource()->getID());
+                    excessTime.push_back(timeFromStart(t.destinationRoad, t.destination));
+                }
+                vector<DijkstraDirectedSP*> found = DijkstraDirectedSP::fromSource(G, trips[order[groupStart[g]]].sourceRoad->getDestination()->getID(), initialTime, destinationIDs, excessTime);
+                for (int i = groupStart[g]; i < groupStart[g + 1]; i++) {
+                    paths[order[i]] = found[i - groupStart[g]];
+                }
+            }
+        });
+    } else if (G->getRoutingMode() == ROUTING_TABLES || G->getRoutingMode() == ROUTING_LIVE) {
+        RoutingTableCache *cache = G->getRoutingTables();
+        vector<int> destinations;
+        for (Trip &t : trips) {
+            destinations.push_back(t.destinationRoad->getSource()->getIndex());
+        }
+        sort(destinations.begin(), destinations.end());
+        destinations.erase(unique(destinations.begin(), destinations.end()), destinations.end());
+        pool->parallelFor(destinations.size(), 1, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                cache->get(destinations[i]);
+            }
+        });
+    } else {
+        if (G->getRoutingMode() == ROUTING_ALT) G->getLandmarks();
+        else if (G->getRoutingMode() == ROUTING_CH) G->getHierarchy();
+        else if (G->getRoutingMode() == ROUTING_TURNS) G->getMovementGraph();
+        else G->getSignalSchedule();
+        pool->parallelFor(trips.size(), 16, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                Trip &t = trips[i];
+                vector<double> initialTime(1, timeToEnd(t.sourceRoad, t.source)), excessTime(1, timeFromStart(t.destinationRoad, t.destination));
+                if (G->getRoutingMode() == ROUTING_TURNS || G->getRoutingMode() == ROUTING_SIGNALS) {
+                    vector<RoadSegment*> sourceRoads(1, t.sourceRoad), destinationRoads(1, t.destinationRoad);
+                    paths[i] = new DijkstraDirectedSP(G, sourceRoads, initialTime, destinationRoads, excessTime, currentTime);
+                } else {
+                    vector<int> sourceIDs(1, t.sourceRoad->getDestination()->getID()), destinationIDs(1, t.destinationRoad->getSource()->getID());
+                    paths[i] = new DijkstraDirectedSP(G, sourceIDs, initialTime, destinationIDs, excessTime);
+                }
+            }
+        });
+    }
+    vector<Car*> cars;
+    for (int i = 0; i < (int) trips.size(); i++) {
+        Trip &t = trips[i];
+        vector<RoadSegment*> sourceRoads(1, t.sourceRoad), destinationRoads(1, t.destinationRoad);
+        cars.push_back(new Car(t.source, t.destination, sourceRoads, destinationRoads, currentTime, G, paths[i]));
+    }
+    return cars;
 }
@@ -1,6 +1,7 @@
 #ifndef CAR_H_
 #define CAR_H_
 
+#include <memory>
 #include <vector>
 #include "Forward.h"
 #include "Point2D.h"
@@ -8,39 +9,32 @@
 #include "Intersection.h"
 #include "WeightedDigraph.h"
 #include "DijkstraDirectedSP.h"
+#include "CarStore.h"
+#include "RoutingTable.h"
+#include "Route.h"
+#include "../misc/ThreadPool.h"
+
+#define TRIP_ATTEMPTS 64 // the number of destinations drawn for a source before the source of a trip is drawn again
+#define TRIP_SOURCES 64 // the number of sources drawn for a trip before the trip is given up
+#define ROAD_ATTEMPTS 4096 // the number of road segments drawn before a draw is given up because they are all full
 
 struct RoadSegment; // forward declaration
 struct Intersection; // foward declaration
 
 struct Car {
 private:
-    static int counter; // number of cars that have been created
-    static double efficiency; // the average efficiency of all cars
-    static int reached; // number of cars that have reached the destination
     int id; // each car has a unique id number
-    double expectedTime; // the expected time for the car to complete its journey
-    double currentSpeed; // the car's curent speed
-    Point2D currentLocation; // the car's current location
-    RoadSegment *currentRoad; // the road the car is currently on
-    RoadSegment *finalRoad; // the final road the car will travel on
-    Point2D source; // the x y location of the source
-    Point2D destination; // the x y location of the destination
-    std::vector<RoadSegment*> sourceRoads; // possible roads the that lead directly out from the source
-    std::vector<RoadSegment*> destinationRoads; // possible roads that lead directly into the destination
-    std::vector<int> sourceIntersections; // IDs of possible source intersections
-    std::vector<int> destinationIntersections; // IDs of possible destination intersections
-    std::vector<double> initialTime; // the initial time to reach of the possible source intersections
-    std::vector<double> excessTime; // the extra time to reach the destination from the possible destination interesctions
-    DijkstraDirectedSP *path; // the path that the car will take
-    int pathIndex; // the current index on the path that the car is on
+    CarHandle handle; // the car's slot in the store
+    CarStore *store; // the store that holds the rest of the car, such as its speed, location, road and route
+
+    RoadSegment *lookUpNextRoad(RoadSegment *r) const;
 
 public:
-    Car(Point2D &source, Point2D &destination, std::vector<RoadSegment*> &sourceRoads, std::vector<RoadSegment*> &destinationRoads, double currentTime, WeightedDigraph *G);
+    Car(Point2D &source, Point2D &destination, std::vector<RoadSegment*> &sourceRoads, std::vector<RoadSegment*> &destinationRoads, double currentTime, WeightedDigraph *G, DijkstraDirectedSP *path = nullptr);
     ~Car();
-    double startTime; // the starting time on the road's journey
     void updateEfficiency(double endTime);
-    static double getEfficiency();
     int getID() const;
+    CarHandle getHandle() const;
     double getElapsedTime(double currentTime) const;
     double getExpectedTime() const;
     double getCurrentSpeed() const;
@@ -51,14 +45,25 @@ public:
     RoadSegment *getNextRoad();
     RoadSegment *peekNextRoad() const;
     void setRoad(RoadSegment *road);
+    double getPosition() const;
     Point2D getCurrentLocation() const;
-    void setLocation(Point2D &location);
-    Point2D getSource() const;
     Point2D getDestination() const;
 };
 
-RoadSegment *getRandomRoadSegment(WeightedDigraph *G);
+/**
+ * A trip from a point on one road segment to a point on another, for a car that has not been created yet.
+ */
+struct Trip {
+    RoadSegment *sourceRoad; // the road the car starts on
+    RoadSegment *destinationRoad; // the road the car finishes on
+    Point2D source; // the exact location of the source in the x, y plane
+    Point2D destination; // the exact location of the destination in the x, y plane
+};
+
+RoadSegment *getRandomRoadSegment(WeightedDigraph *G, const std::vector<int> &reserved);
 Point2D getRandomLocation(RoadSegment *r);
+std::vector<Trip> getRandomTrips(WeightedDigraph *G, int n);
 Car *getRandomCar(WeightedDigraph *G, double currentTime);
+std::vector<Car*> createCars(WeightedDigraph *G, std::vector<Trip> &trips, double currentTime, ThreadPool *pool);
 
 #endif
@@ -0,0 +1,197 @@
+#include <assert.h>
+#include "CarStore.h"
+#include "Car.h"
+
+using namespace std;
+
+/**
+ * Initializes an empty car store.
+ */
+CarStore::CarStore() {
+    live = 0;
+}
+
+/**
+ * Deconstructs the car store and the cars that are still in it.
+ */
+CarStore::~CarStore() {
+    collect();
+    for (int i = 0; i < (int) cars.size(); i++) {
+        delete cars[i];
+    }
+}
+
+/**
+ * Gives a car a slot in the store, reusing a free slot if there is one.
+ * @param c the pointer to the car
+ * @return the handle of the slot
+ */
+CarHandle CarStore::allocate(Car *c) {
+    int index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        index = cars.size();
+        position.push_back(0.0);
+        target.push_back(0.0);
+        speed.push_back(0.0);
+        stopped.push_back(false);
+        road.push_back(nullptr);
+        pathIndex.push_back(-1);
+        entered.push_back(-1.0);
+        finalRoad.push_back(nullptr);
+        finalPosition.push_back(0.0);
+        nextRoad.push_back(nullptr);
+        route.push_back(nullptr);
+        table.push_back(nullptr);
+        start.push_back(0.0);
+        expected.push_back(0.0);
+        cars.push_back(nullptr);
+        generation.push_back(0);
+    }
+    position[index] = 0.0;
+    target[index] = 0.0;
+    speed[index] = 0.0;
+    stopped[index] = false;
+    road[index] = nullptr;
+    pathIndex[index] = -1;
+    entered[index] = -1.0;
+    finalRoad[index] = nullptr;
+    finalPosition[index] = 0.0;
+    nextRoad[index] = nullptr;
+    start[index] = 0.0;
+    expected[index] = 0.0;
+    cars[index] = c;
+    live++;
+    newCars.push_back({index, generation[index]});
+    return {index, generation[index]};
+}
+
+/**
+ * Releases the slot of a car. The handle becomes stale immediately, but the car is only deleted and the slot
+ * is only reused after the next collection.
+ * @param h the handle of the car
+ */
+void CarStore::release(CarHandle h) {
+    assert(isValid(h) && "the handle is stale");
+    generation[h.index]++;
+    released.push_back(h.index);
+    live--;
+}
+
+/**
+ * Deletes the cars released since the last collection and makes their slots free. Their routes and routing tables
+ * are let go, so a route is deleted with the last car that follows it.
+ */
+void CarStore::collect() {
+    for (int index : released) {
+        delete cars[index];
+        cars[index] = nullptr;
+        road[index] = nullptr;
+        route[index] = nullptr;
+        table[index] = nullptr;
+        freeSlots.push_back(index);
+    }
+    released.clear();
+}
+
+/**
+ * Returns true if the handle refers to a car that has not been released, false otherwise.
+ * @param h the handle of the car
+ */
+bool CarStore::isValid(CarHandle h) const {
+    return h.index >= 0 && h.index < (int) generation.size() && generation[h.index] == h.generation;
+}
+
+/**
+ * Returns the number of cars in the store.
+ */
+int CarStore::size() const { return live; }
+
+/**
+ * Returns a pointer to the car given its handle.
+ * @param h the handle of the car
+ */
+Car *CarStore::getCar(CarHandle h) const {
+    assert(isValid(h) && "the handle is stale");
+    return cars[h.index];
+}
+
+/**
+ * Returns a reference to the distances the cars have travelled along their current road, indexed by slot.
+ */
+vector<double> &CarStore::getPositions() { return position; }
+
+/**
+ * Returns a reference to the positions where the cars will leave their current road, indexed by slot.
+ */
+vector<double> &CarStore::getTargets() { return target; }
+
+/**
+ * Returns a reference to the speeds of the cars, indexed by slot.
+ */
+vector<double> &CarStore::getSpeeds() { return speed; }
+
+/**
+ * Returns a reference to whether the cars are waiting in the queue of their road, indexed by slot.
+ */
+vector<char> &CarStore::getStopped() { return stopped; }
+
+/**
+ * Returns a reference to the roads the cars are on, indexed by slot.
+ */
+vector<RoadSegment*> &CarStore::getRoads() { return road; }
+
+/**
+ * Returns a reference to the path indices of the cars, indexed by slot.
+ */
+vector<int> &CarStore::getPathIndices() { return pathIndex; }
+
+/**
+ * Returns a reference to the times the cars entered their current road, indexed by slot. A car that started in the
+ * middle of its road has -1, since its time on the road says nothing about the time to travel it.
+ */
+vector<double> &CarStore::getEntryTimes() { return entered; }
+
+/**
+ * Returns a reference to the handles allocated since the simulation last took them.
+ * The simulation clears the list once it has seen the new cars.
+ */
+vector<CarHandle> &CarStore::getNewCars() { return newCars; }
+
+/**
+ * Returns a reference to the final roads of the cars, indexed by slot.
+ */
+vector<RoadSegment*> &CarStore::getFinalRoads() { return finalRoad; }
+
+/**
+ * Returns a reference to the distances from the source of the final road to the destination of the cars, indexed by slot.
+ */
+vector<double> &CarStore::getFinalPositions() { return finalPosition; }
+
+/**
+ * Returns a reference to the roads the cars that follow a routing table take after the one they entered last,
+ * indexed by slot.
+ */
+vector<RoadSegment*> &CarStore::getNextRoads() { return nextRoad; }
+
+/**
+ * Returns a reference to the interned routes of the cars, indexed by slot.
+ */
+vector<shared_ptr<const Route>> &CarStore::getRoutes() { return route; }
+
+/**
+ * Returns a reference to the routing tables of the destinations of the cars, indexed by slot.
+ */
+vector<shared_ptr<const RoutingTable>> &CarStore::getTables() { return table; }
+
+/**
+ * Returns a reference to the times the cars started their journey, indexed by slot.
+ */
+vector<double> &CarStore::getStartTimes() { return start; }
+
+/**
+ * Returns a reference to the times the cars are expected to take to complete their journey, indexed by slot.
+ */
+vector<double> &CarStore::getExpectedTimes() { return expected; }
@@ -0,0 +1,70 @@
+#ifndef CARSTORE_H_
+#define CARSTORE_H_
+
+#include <memory>
+#include <vector>
+#include "Forward.h"
+
+/**
+ * Refers to a slot in the CarStore. A handle becomes stale once its car is released, even if the slot is reused.
+ */
+struct CarHandle {
+    int index; // the slot in the car store
+    int generation; // the generation of the slot when the handle was made
+};
+
+/**
+ * Keeps the fields of the cars in contiguous arrays, indexed by slot. The fields that are updated every iteration come
+ * first, and the rest of each car is only read when it changes roads or arrives.
+ * Released slots are recycled in bulk by collect() at the end of an iteration.
+ */
+struct CarStore {
+private:
+    std::vector<double> position; // the distance the car in each slot has travelled along its current road
+    std::vector<double> target; // the position where the car in each slot will leave its current road
+    std::vector<double> speed; // the current speed of the car in each slot
+    std::vector<char> stopped; // whether the car in each slot is waiting in the queue of its road
+    std::vector<RoadSegment*> road; // the road the car in each slot is currently on
+    std::vector<int> pathIndex; // the current index on the path of the car in each slot
+    std::vector<double> entered; // the time the car in each slot entered its current road, -1 if it started on it
+    std::vector<RoadSegment*> finalRoad; // the final road the car in each slot will travel on
+    std::vector<double> finalPosition; // the distance from the source of the final road to the destination of the car in each slot
+    std::vector<RoadSegment*> nextRoad; // the road the car in each slot takes after the one it entered last, nullptr if that is the final road (only used with a routing table)
+    std::vector<std::shared_ptr<const Route>> route; // the interned route of the car in each slot, nullptr if the car follows a routing table
+    std::vector<std::shared_ptr<const RoutingTable>> table; // the routing table of the destination of the car in each slot, nullptr if the car has a route
+    std::vector<double> start; // the time the car in each slot started its journey
+    std::vector<double> expected; // the time the car in each slot is expected to take to complete its journey
+    std::vector<Car*> cars; // the rest of the car in each slot
+    std::vector<int> generation; // incremented each time the slot is released
+    std::vector<int> freeSlots; // slots that can be reused
+    std::vector<int> released; // slots released since the last collection
+    std::vector<CarHandle> newCars; // handles allocated since the simulation last took them
+    int live; // the number of cars in the store
+
+public:
+    CarStore();
+    ~CarStore();
+    CarHandle allocate(Car *c);
+    void release(CarHandle h);
+    void collect();
+    bool isValid(CarHandle h) const;
+    int size() const;
+    Car *getCar(CarHandle h) const;
+    std::vector<double> &getPositions();
+    std::vector<double> &getTargets();
+    std::vector<double> &getSpeeds();
+    std::vector<char> &getStopped();
+    std::vector<RoadSegment*> &getRoads();
+    std::vector<int> &getPathIndices();
+    std::vector<double> &getEntryTimes();
+    std::vector<RoadSegment*> &getFinalRoads();
+    std::vector<double> &getFinalPositions();
+    std::vector<RoadSegment*> &getNextRoads();
+    std::vector<std::shared_ptr<const Route>> &getRoutes();
+    std::vector<std::shared_ptr<const RoutingTable>> &getTables();
+    std::vector<double> &getStartTimes();
+    std::vector<double> &getExpectedTimes();
+    std::vector<CarHandle> &getNewCars();
+};
+
+#endif
@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <assert.h>
+#include "ContractionHierarchy.h"
+#include "CSRGraph.h"
+#include "RoutingWorkspace.h"
+
+using namespace std;
+
+/**
+ * Builds the contraction hierarchy of a compiled graph. Each round works out the priority of every intersection whose
+ * neighbourhood changed, which is the number of shortcuts its contraction needs minus the number of arcs it removes
+ * plus the number of its neighbours already contracted. The intersections whose priority is lower than that of each
+ * of their neighbours form an independent set, and their shortcuts are found in parallel with witness searches that
+ * avoid the whole set. The shortcuts are then added in order of index, so the hierarchy is the same for any number
+ * of threads.
+ * @param C the compiled graph
+ * @param pool the threads used to contract the intersections
+ */
+ContractionHierarchy::ContractionHierarchy(CSRGraph *C, ThreadPool *pool) {
+    assert(pool != nullptr && "pool must not be null");
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    this->C = C;
+    int n = C->countIntersections(), m = C->countRoadSegments();
+    vector<vector<Edge>> out(n), in(n);
+    // adds an arc unless a faster one joins the same intersections, and returns true if it was added
+    auto link = [&](const Arc &a) {
+        for (Edge &e : out[a.from]) {
+            if (e.node != a.to) continue;
+            if (e.time <= a.time) return false;
+            e.arc = arcs.size();
+            e.time = a.time;
+            for (Edge &f : in[a.to]) {
+                if (f.node == a.from) {
+                    f.arc = arcs.size();
+                    f.time = a.time;
+                }
+            }
+            arcs.push_back(a);
+            return true;
+        }
+        out[a.from].push_back({a.to, (int) arcs.size(), a.time});
+        in[a.to].push_back({a.from, (int) arcs.size(), a.time});
+        arcs.push_back(a);
+        return true;
+    };
+    for (int e = 0; e < m; e++) {
+        int s = C->getSources()[e], d = C->getDestinations()[e];
+        if (s != d) link({s, d, C->getExpectedTimes()[e], e, -1, -1});
+    }
+    vector<int> remaining(n), priority(n), deleted(n, 0);
+    vector<char> dirty(n, 1), selected(n, 0);
+    for (int v = 0; v < n; v++) {
+        remaining[v] = v;
+    }
+    rank.assign(n, -1);
+    rounds = shortcuts = 0;
+    int contracted = 0;
+    while (!remaining.empty()) {
+        vector<int> update;
+        for (int u : remaining) {
+            if (dirty[u]) update.push_back(u);
+        }
+        pool->parallelFor(update.size(), 16, [&](int begin, int end) {
+            vector<Arc> added;
+            for (int i = begin; i < end; i++) {
+                int u = update[i];
+                added.clear();
+                contract(u, out, in, selected, added);
+                priority[u] = (int) added.size() - (int) (in[u].size() + out[u].size()) + deleted[u];
+                dirty[u] = 0;
+            }
+        });
+        vector<int> independent; // the intersections with a lower priority than each of their neighbours
+        for (int u : remaining) {
+            bool lowest = true;
+            for (const vector<Edge> *edges : {&out[u], &in[u]}) {
+                for (const Edge &e : *edges) {
+                    if (priority[e.node] < priority[u] || (priority[e.node] == priority[u] && e.node < u)) lowest = false;
+                }
+            }
+            if (lowest) {
+                independent.push_back(u);
+                selected[u] = 1;
+            }
+        }
+        vector<vector<Arc>> found(independent.size());
+        pool->parallelFor(independent.size(), 4, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                contract(independent[i], out, in, selected, found[i]);
+            }
+        });
+        for (int i = 0; i < (int) independent.size(); i++) {
+            int u = independent[i];
+            rank[u] = contracted++;
+            for (const Arc &a : found[i]) {
+                if (link(a)) shortcuts++;
+            }
+            // the lists of u are kept as they are, since they hold its arcs to more important intersections
+            for (const Edge &e : out[u]) {
+                in[e.node].erase(remove_if(in[e.node].begin(), in[e.node].end(), [u](const Edge &f) { return f.node == u; }), in[e.node].end());
+                deleted[e.node]++;
+                dirty[e.node] = 1;
+            }
+            for (const Edge &e : in[u]) {
+                out[e.node].erase(remove_if(out[e.node].begin(), out[e.node].end(), [u](const Edge &f) { return f.node == u; }), out[e.node].end());
+                deleted[e.node]++;
+                dirty[e.node] = 1;
+            }
+        }
+        remaining.erase(remove_if(remaining.begin(), remaining.end(), [&](int u) { return rank[u] != -1; }), remaining.end());
+        rounds++;
+    }
+    upStart.assign(n + 1, 0);
+    downStart.assign(n + 1, 0);
+    for (int v = 0; v < n; v++) {
+        upStart[v + 1] = upStart[v] + out[v].size();
+        downStart[v + 1] = downStart[v] + in[v].size();
+        for (const Edge &e : out[v]) {
+            upArcs.push_back(e.arc);
+        }
+        for (const Edge &e : in[v]) {
+            downArcs.push_back(e.arc);
+        }
+    }
+    preprocessingTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Deconstructs the contraction hierarchy. The compiled graph is not deleted.
+ */
+ContractionHierarchy::~ContractionHierarchy() {}
+
+/**
+ * Finds the shortcuts needed to contract an intersection. For each inbound neighbour, a search that avoids the
+ * intersection and every excluded intersection looks for a witness path to each outbound neighbour that is no slower
+ * than the path through the intersection. The search gives up after settling WITNESS_LIMIT intersections, in which
+ * case a shortcut may be added that is not needed, but none that is needed is left out.
+ * @param u the index of the intersection
+ * @param out the outbound arcs of each intersection that is not contracted
+ * @param in the inbound arcs of each intersection that is not contracted
+ * @param excluded whether each intersection is being contracted in the same round
+ * @param added the vector to append the shortcuts to
+ */
+void ContractionHierarchy::contract(int u, const vector<vector<Edge>> &out, const vector<vector<Edge>> &in, const vector<char> &excluded, vector<Arc> &added) const {
+    RoutingWorkspace &W = RoutingWorkspace::local();
+    for (const Edge &a : in[u]) {
+        int v = a.node;
+        double limit = -1.0; // the slowest path through u from v
+        for (const Edge &b : out[u]) {
+            if (b.node != v) limit = max(limit, a.time + b.time);
+        }
+        if (limit < 0.0) continue;
+        W.reset(C->countIntersections());
+        RadixHeap &pq = W.getHeap();
+        W.setTime(v, 0.0, -1);
+        pq.push(0.0, v);
+        int settled = 0;
+        while (!pq.empty() && settled < WITNESS_LIMIT) {
+            pair<double, int> top = pq.pop();
+            int x = top.second;
+            if (W.isSettled(x)) continue;
+            if (top.first > limit) break;
+            W.settle(x);
+            settled++;
+            for (const Edge &c : out[x]) {
+                if (c.node == u || excluded[c.node]) continue;
+                if (W.getTime(c.node) > top.first + c.time) {
+                    W.setTime(c.node, top.first + c.time, -1);
+                    pq.push(top.first + c.time, c.node);
+                }
+            }
+        }
+        for (const Edge &b : out[u]) {
+            // any path found is a witness, even if the search stopped before settling its end
+            if (b.node != v && W.getTime(b.node) > a.time + b.time) added.push_back({v, b.node, a.time + b.time, -1, a.arc, b.arc});
+        }
+    }
+}
+
+/**
+ * Returns true if a search reached an intersection faster through a more important intersection than it settled it.
+ * The shortest path to such an intersection goes down from the more important one, which a search that only goes up
+ * never follows, so its arcs do not need to be relaxed.
+ * @param v the index of the intersection
+ * @param time the time the intersection was settled with
+ * @param W the workspace of the search
+ * @param start the start of the arcs of each intersection that lead the opposite way to the search
+ * @param opposite the indices of the arcs that lead the opposite way to the search
+ * @param backward true for the backward search, false for the forward search
+ */
+bool ContractionHierarchy::stalled(int v, double time, const RoutingWorkspace &W, const vector<int> &start, const vector<int> &opposite, bool backward) const {
+    for (int i = start[v]; i < start[v + 1]; i++) {
+        const Arc &a = arcs[opposite[i]];
+        if (W.getTime(backward ? a.to : a.from) + a.time < time) return true;
+    }
+    return false;
+}
+
+/**
+ * Appends the road segments of an arc to a path, expanding shortcuts into the arcs they skip over.
+ * @param arc the index of the arc
+ * @param path the path to append to
+ */
+void ContractionHierarchy::unpack(int arc, vector<RoadSegment*> &path) const {
+    vector<int> stk(1, arc);
+    while (!stk.empty()) {
+        const Arc &a = arcs[stk.back()];
+        stk.pop_back();
+        if (a.road != -1) {
+            path.push_back(C->getRoadSegment(a.road));
+        } else {
+            stk.push_back(a.second);
+            stk.push_back(a.first);
+        }
+    }
+}
+
+/**
+ * Finds the fastest route at the speed limit from any of the sources to any of the destinations. The forward search
+ * goes up from the sources and settles everything it can reach. The backward search goes up from the destinations and
+ * stops once it cannot beat the best meeting point. Only the workspaces of the calling thread are used.
+ * @param sources the indices of the source intersections
+ * @param initialTime the initial time to each of the sources
+ * @param destinations the indices of the possible destination intersections
+ * @param excessTime the extra time required for each of the possible destinations
+ * @param path the vector to fill with the road segments of the route
+ * @return the time of the route including the initial and excess times, infinity if there is none
+ */
+double ContractionHierarchy::route(vector<int> &sources, vector<double> &initialTime, vector<int> &destinations, vector<double> &excessTime, vector<RoadSegment*> &path) const {
+    int n = C->countIntersections();
+    RoutingWorkspace &F = RoutingWorkspace::local(0), &B = RoutingWorkspace::local(1);
+    F.reset(n);
+    B.reset(n);
+    RadixHeap &forward = F.getHeap(), &backward = B.getHeap();
+    for (int s = 0; s < (int) sources.size(); s++) {
+        if (initialTime[s] >= F.getTime(sources[s])) continue;
+        F.setTime(sources[s], initialTime[s], -1);
+        forward.push(initialTime[s], sources[s]);
+    }
+    while (!forward.empty()) {
+        pair<double, int> top = forward.pop();
+        int v = top.second;
+        if (F.isSettled(v)) continue;
+        F.settle(v);
+        if (stalled(v, top.first, F, downStart, downArcs, false)) continue;
+        for (int i = upStart[v]; i < upStart[v + 1]; i++) {
+            const Arc &a = arcs[upArcs[i]];
+            if (F.getTime(a.to) > top.first + a.time) {
+                F.setTime(a.to, top.first + a.time, upArcs[i]);
+                forward.push(top.first + a.time, a.to);
+            }
+        }
+    }
+    for (int d = 0; d < (int) destinations.size(); d++) {
+        if (excessTime[d] >= B.getTime(destinations[d])) continue;
+        B.setTime(destinations[d], excessTime[d], -1);
+        backward.push(excessTime[d], destinations[d]);
+    }
+    double best = numeric_limits<double>::infinity();
+    int meet = -1; // the intersection where the best route goes from the forward search to the backward search
+    while (!backward.empty()) {
+        pair<double, int> top = backward.pop();
+        int v = top.second;
+        if (B.isSettled(v)) continue;
+        if (top.first >= best) break;
+        B.settle(v);
+        if (F.getTime(v) + top.first < best) {
+            best = F.getTime(v) + top.first;
+            meet = v;
+        }
+        if (stalled(v, top.first, B, upStart, upArcs, true)) continue;
+        for (int i = downStart[v]; i < downStart[v + 1]; i++) {
+            const Arc &a = arcs[downArcs[i]];
+            if (B.getTime(a.from) > top.first + a.time) {
+                B.setTime(a.from, top.first + a.time, downArcs[i]);
+                backward.push(top.first + a.time, a.from);
+            }
+        }
+    }
+    path.clear();
+    if (meet == -1) return best;
+    vector<int> up;
+    for (int v = meet; F.getRoad(v) != -1; v = arcs[F.getRoad(v)].from) {
+        up.push_back(F.getRoad(v));
+    }
+    for (int i = up.size() - 1; i >= 0; i--) {
+        unpack(up[i], path);
+    }
+    for (int v = meet; B.getRoad(v) != -1; v = arcs[B.getRoad(v)].to) {
+        unpack(B.getRoad(v), path);
+    }
+    return best;
+}
+
+/**
+ * Returns the order in which an intersection was contracted, where the most important intersection is last.
+ * @param v the index of the intersection
+ */
+int ContractionHierarchy::getRank(int v) const { return rank[v]; }
+
+/**
+ * Returns the number of rounds of contraction, each of which contracted an independent set of intersections.
+ */
+int ContractionHierarchy::countRounds() const { return rounds; }
+
+/**
+ * Returns the number of shortcuts added.
+ */
+int ContractionHierarchy::countShortcuts() const { return shortcuts; }
+
+/**
+ * Returns the number of arcs searched by queries, which are the road segments and shortcuts that were not replaced.
+ */
+int ContractionHierarchy::countArcs() const { return upArcs.size(); }
+
+/**
+ * Returns the wall clock time spent building the hierarchy in seconds.
+ */
+double ContractionHierarchy::getPreprocessingTime() const { return preprocessingTime; }
+
+/**
+ * Prints the node ordering and shortcut statistics of the hierarchy.
+ */
+void ContractionHierarchy::printStatistics() const {
+    int n = rank.size();
+    printf("contraction hierarchy: %d intersections contracted in %d rounds\n", n, rounds);
+    printf("shortcuts added: %d (%d arcs, %.2f per intersection)\n", shortcuts, countArcs(), n > 0 ? (double) countArcs() / n : 0.0);
+    printf("preprocessing time: %.3f s\n", preprocessingTime);
+}
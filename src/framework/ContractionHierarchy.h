@@ -0,0 +1,68 @@
+#ifndef CONTRACTIONHIERARCHY_H_
+#define CONTRACTIONHIERARCHY_H_
+
+#include <vector>
+#include "Forward.h"
+#include "../misc/ThreadPool.h"
+
+#define WITNESS_LIMIT 500 // the most intersections a witness search settles before it gives up and adds the shortcut
+
+/**
+ * A contraction hierarchy of a compiled graph, weighted by the time to travel each road segment at the speed limit.
+ * Intersections are contracted from least to most important. Contracting an intersection removes it and adds a
+ * shortcut between each pair of its neighbours whose shortest path ran through it. A route is then found by two small
+ * searches that only go up in importance, one from the sources and one backwards from the destinations.
+ * Each round contracts an independent set of intersections in parallel, so the result does not depend on the number
+ * of threads. The hierarchy is immutable once built, and queries only use the workspaces of the calling thread.
+ */
+struct ContractionHierarchy {
+private:
+    /**
+     * An arc of the hierarchy, which is either a road segment or a shortcut over two arcs.
+     */
+    struct Arc {
+        int from; // the index of the intersection the arc leaves
+        int to; // the index of the intersection the arc enters
+        double time; // the time to travel the arc at the speed limit
+        int road; // the index of the road segment, -1 for a shortcut
+        int first; // the first arc of a shortcut, -1 for a road segment
+        int second; // the second arc of a shortcut, -1 for a road segment
+    };
+
+    /**
+     * An arc in the adjacency lists used while contracting.
+     */
+    struct Edge {
+        int node; // the index of the intersection at the other end
+        int arc; // the index of the arc
+        double time; // the time to travel the arc
+    };
+
+    CSRGraph *C; // the compiled graph
+    std::vector<Arc> arcs; // the road segments and shortcuts
+    std::vector<int> rank; // the order in which each intersection was contracted
+    std::vector<int> upStart; // the arcs from intersection v to more important ones are upArcs[upStart[v]..upStart[v + 1])
+    std::vector<int> upArcs; // the indices of the arcs to more important intersections
+    std::vector<int> downStart; // the arcs into v from more important ones are downArcs[downStart[v]..downStart[v + 1])
+    std::vector<int> downArcs; // the indices of the arcs from more important intersections
+    int rounds; // the number of rounds of contraction
+    int shortcuts; // the number of shortcuts added
+    double preprocessingTime; // the wall clock time spent building the hierarchy in seconds
+
+    void contract(int u, const std::vector<std::vector<Edge>> &out, const std::vector<std::vector<Edge>> &in, const std::vector<char> &excluded, std::vector<Arc> &added) const;
+    bool stalled(int v, double time, const RoutingWorkspace &W, const std::vector<int> &start, const std::vector<int> &opposite, bool backward) const;
+    void unpack(int arc, std::vector<RoadSegment*> &path) const;
+
+public:
+    ContractionHierarchy(CSRGraph *C, ThreadPool *pool);
+    ~ContractionHierarchy();
+    double route(std::vector<int> &sources, std::vector<double> &initialTime, std::vector<int> &destinations, std::vector<double> &excessTime, std::vector<RoadSegment*> &path) const;
+    int getRank(int v) const;
+    int countRounds() const;
+    int countShortcuts() const;
+    int countArcs() const;
+    double getPreprocessingTime() const;
+    void printStatistics() const;
+};
+
+#endif
@@ -2,7 +2,6 @@
 #include <functional>
 #include <limits>
 #include <stack>
-#include <queue>
 #include <assert.h>
 #include "DijkstraDirectedSP.h"
 
@@ -17,26 +16,128 @@ using namespace std;
  * @param excesstime the extra time required for each of the possible destinations
  */
 DijkstraDirectedSP::DijkstraDirectedSP(WeightedDigraph *G, vector<int> &sourceIDs, vector<double> &initialTime, vector<int> &destinationIDs, vector<double> &excessTime) {
-    dijkstra(G, sourceIDs, initialTime);
+    CSRGraph *C = G->getCompiled();
+    vector<int> sources, destinations;
+    for (int id : sourceIDs) {
+        sources.push_back(G->getIntersection(id)->getIndex());
+    }
+    for (int id : destinationIDs) {
+        destinations.push_back(G->getIntersection(id)->getIndex());
+    }
+    if (G->getRoutingMode() == ROUTING_CH) {
+        shortestPathSourceID = shortestPathDestinationID = -1;
+        shortestTime = G->getHierarchy()->route(sources, initialTime, destinations, excessTime, shortestPath);
+        if (shortestTime != numeric_limits<double>::infinity()) {
+            assert(!shortestPath.empty() && "no path for car to reach destination from sources");
+            shortestPathSourceID = shortestPath.front()->getSource()->getID();
+            shortestPathDestinationID = shortestPath.back()->getDestination()->getID();
+        }
+        return;
+    }
+    RoutingWorkspace &W = RoutingWorkspace::local();
+    Landmarks *L = G->getRoutingMode() == ROUTING_ALT ? G->getLandmarks() : nullptr;
+    dijkstra(C, L, W, sources, initialTime, destinations, excessTime, false);
     shortestPathSourceID = shortestPathDestinationID = -1;
     shortestTime = numeric_limits<double>::infinity();
-    for (int d = 0; d < destinationIDs.size(); d++) {
-        if (timeTo[destinationIDs[d]] + excessTime[d] < shortestTime) {
-            shortestTime = timeTo[destinationIDs[d]] + excessTime[d];
+    int destination = -1;
+    for (int d = 0; d < (int) destinations.size(); d++) {
+        if (W.getTime(destinations[d]) + excessTime[d] < shortestTime) {
+            shortestTime = W.getTime(destinations[d]) + excessTime[d];
             shortestPathDestinationID = destinationIDs[d];
+            destination = destinations[d];
         }
     }
+    if (shortestTime != numeric_limits<double>::infinity()) readPath(C, W, destination);
+}
+
+/**
+ * Calculates the shortest path between road segments in the movement graph, so every turn on the path is allowed
+ * by the traffic lights of its intersection and costs its penalty. With ROUTING_SIGNALS, the path arrives earliest
+ * given the schedule of the traffic lights instead. The path does not include the source and destination road
+ * segments, and is empty if the source road segment leads directly into the destination.
+ * @param G the Weighted Directed Graph
+ * @param sourceRoads the road segments the car can start on
+ * @param initialTime the time to reach the end of each source road segment
+ * @param destinationRoads the road segments the car can finish on
+ * @param excessTime the time from the start of each destination road segment to the destination
+ * @param departureTime the time the car leaves (only used with ROUTING_SIGNALS)
+ */
+DijkstraDirectedSP::DijkstraDirectedSP(WeightedDigraph *G, vector<RoadSegment*> &sourceRoads, vector<double> &initialTime, vector<RoadSegment*> &destinationRoads, vector<double> &excessTime, double departureTime) {
+    G->getCompiled(); // the road segments get their indices
+    vector<int> sources, destinations;
+    for (RoadSegment *r : sourceRoads) {
+        sources.push_back(r->getIndex());
+    }
+    for (RoadSegment *r : destinationRoads) {
+        destinations.push_back(r->getIndex());
+    }
+    int source, destination;
+    if (G->getRoutingMode() == ROUTING_SIGNALS) shortestTime = G->getSignalSchedule()->route(sources, initialTime, destinations, excessTime, departureTime, source, destination, shortestPath);
+    else shortestTime = G->getMovementGraph()->route(sources, initialTime, destinations, excessTime, source, destination, shortestPath);
+    shortestPathSourceID = source == -1 ? -1 : sourceRoads[source]->getDestination()->getID();
+    shortestPathDestinationID = destination == -1 ? -1 : destinationRoads[destination]->getSource()->getID();
+}
+
+/**
+ * Reads the shortest path to one destination from a search that settled it.
+ * @param C the compiled graph
+ * @param W the workspace of the search
+ * @param destination the index of the destination intersection
+ * @param destinationID the intersection ID of the destination
+ * @param initialTime the initial time to the source of the search
+ * @param excessTime the extra time required for the destination
+ */
+DijkstraDirectedSP::DijkstraDirectedSP(CSRGraph *C, RoutingWorkspace &W, int destination, int destinationID, double initialTime, double excessTime) {
+    shortestPathSourceID = shortestPathDestinationID = -1;
+    shortestTime = initialTime + W.getTime(destination) + excessTime;
     if (shortestTime != numeric_limits<double>::infinity()) {
-        stack<RoadSegment*> stk;
-        for (RoadSegment *r = roadTo[shortestPathDestinationID]; r != nullptr; r = roadTo[r->getSource()->getID()]) {
-            stk.push(r);
-        }
-        assert(!stk.empty() && "no path for car to reach destination from sources");
-        shortestPathSourceID = stk.top()->getSource()->getID();
-        while (!stk.empty()) {
-            shortestPath.push_back(stk.top());
-            stk.pop();
-        }
+        shortestPathDestinationID = destinationID;
+        readPath(C, W, destination);
+    }
+}
+
+/**
+ * Calculates the shortest paths from one source to many destinations with a single search, which stops once every
+ * destination is settled. The search starts at time 0, so each path is the same whatever its initial time.
+ * @param G the Weighted Directed Graph
+ * @param sourceID the intersection ID of the source
+ * @param initialTime the initial time to the source for each of the destinations
+ * @param destinationIDs the intersection IDs of the destinations
+ * @param excessTime the extra time required for each of the destinations
+ * @return the shortest path to each of the destinations
+ */
+vector<DijkstraDirectedSP*> DijkstraDirectedSP::fromSource(WeightedDigraph *G, int sourceID, vector<double> &initialTime, vector<int> &destinationIDs, vector<double> &excessTime) {
+    CSRGraph *C = G->getCompiled();
+    vector<int> sources(1, G->getIntersection(sourceID)->getIndex()), destinations;
+    for (int id : destinationIDs) {
+        destinations.push_back(G->getIntersection(id)->getIndex());
+    }
+    vector<double> start(1, 0.0), excess(destinations.size(), 0.0);
+    RoutingWorkspace &W = RoutingWorkspace::local();
+    dijkstra(C, nullptr, W, sources, start, destinations, excess, true);
+    vector<DijkstraDirectedSP*> paths;
+    for (int d = 0; d < (int) destinations.size(); d++) {
+        paths.push_back(new DijkstraDirectedSP(C, W, destinations[d], destinationIDs[d], initialTime[d], excessTime[d]));
+    }
+    return paths;
+}
+
+/**
+ * Follows the last road of each intersection back from a destination to build the shortest path to it.
+ * @param C the compiled graph
+ * @param W the workspace of the search
+ * @param destination the index of the destination intersection
+ */
+void DijkstraDirectedSP::readPath(CSRGraph *C, RoutingWorkspace &W, int destination) {
+    stack<RoadSegment*> stk;
+    for (int e = W.getRoad(destination); e != -1; e = W.getRoad(C->getSources()[e])) {
+        stk.push(C->getRoadSegment(e));
+    }
+    assert(!stk.empty() && "no path for car to reach destination from sources");
+    shortestPathSourceID = stk.top()->getSource()->getID();
+    while (!stk.empty()) {
+        shortestPath.push_back(stk.top());
+        stk.pop();
     }
 }
 
@@ -46,30 +147,70 @@ DijkstraDirectedSP::DijkstraDirectedSP(WeightedDigraph *G, vector<int> &sourceID
 DijkstraDirectedSP::~DijkstraDirectedSP() {}
 
 /**
- * Performs Dijkstra's Single Source Shortest Path Algorithm
- * @param G the Weighted Directed Graph
- * @param sourceIDs the intersection IDs of the sources
+ * Performs Dijkstra's algorithm on the compiled graph in the workspace of the calling thread, or A* if landmarks are
+ * given. A* orders the intersections by the time to them plus a lower bound on the time left to the best destination,
+ * which is the least over the destinations of the bound to the destination plus its excess time. The bound is
+ * consistent, so each intersection is still settled once, and the search heads towards the destinations instead of
+ * growing in every direction.
+ * The search stops once every destination is settled, or unless all of them are wanted, once no unsettled destination
+ * can beat the best destination found so far. Entries for intersections that are already settled are skipped.
+ * @param C the compiled graph
+ * @param L the landmarks of the compiled graph, nullptr for Dijkstra's algorithm
+ * @param W the workspace
+ * @param sources the indices of the source intersections
  * @param initialTime the initial time to each of the sources
+ * @param destinations the indices of the possible destination intersections
+ * @param excessTime the extra time required for each of the possible destinations
+ * @param all true to settle every destination, false to stop at the best one
  */
-void DijkstraDirectedSP::dijkstra(WeightedDigraph *G, vector<int> &sourceIDs, vector<double> &initialTime) {
-    priority_queue<pair<double, int>, vector<pair<double, int>> , greater<pair<double, int>>> pq;
-    for (pair<int, Intersection*> i : G->getIntersections()) {
-        timeTo[i.first] = numeric_limits<double>::infinity();
+void DijkstraDirectedSP::dijkstra(CSRGraph *C, Landmarks *L, RoutingWorkspace &W, vector<int> &sources, vector<double> &initialTime, vector<int> &destinations, vector<double> &excessTime, bool all) {
+    const vector<int> &outStart = C->getOutStart(), &outRoads = C->getOutRoads(), &destination = C->getDestinations();
+    const vector<double> &expectedTime = C->getExpectedTimes();
+    W.reset(C->countIntersections());
+    RadixHeap &pq = W.getHeap();
+    int remaining = 0; // the number of destinations that are not settled
+    for (int v : destinations) {
+        if (!W.isTarget(v)) remaining++;
+        W.markTarget(v);
     }
-    for (int s = 0; s < sourceIDs.size(); s++) {
-        timeTo[sourceIDs[s]] = initialTime[s];
-        roadTo[sourceIDs[s]] = nullptr;
-        pq.push({timeTo[sourceIDs[s]], sourceIDs[s]});
+    // the lower bound on the time left from an intersection to the best destination, 0 for Dijkstra's algorithm
+    auto estimate = [&](int v) {
+        if (L == nullptr) return 0.0;
+        if (W.hasEstimate(v)) return W.getEstimate(v);
+        double bound = numeric_limits<double>::infinity();
+        for (int d = 0; d < (int) destinations.size(); d++) {
+            bound = min(bound, L->lowerBound(v, destinations[d]) + excessTime[d]);
+        }
+        W.setEstimate(v, bound);
+        return bound;
+    };
+    double last = 0.0; // the last key removed, since rounding in the bounds must not make the keys decrease
+    for (int s = 0; s < (int) sources.size(); s++) {
+        if (initialTime[s] >= W.getTime(sources[s])) continue;
+        W.setTime(sources[s], initialTime[s], -1);
+        pq.push(initialTime[s] + estimate(sources[s]), sources[s]);
     }
-    while (!pq.empty()) {
-        int v = pq.top().second;
-        pq.pop();
-        for (pair<int, RoadSegment*> r : G->getIntersection(v)->getOutboundRoads()) {
-            int w = r.second->getDestination()->getID();
-            if (timeTo[w] > timeTo[v] + r.second->getExpectedTime()) {
-                timeTo[w] = timeTo[v] + r.second->getExpectedTime();
-                roadTo[w] = r.second;
-                pq.push({timeTo[w], w});
+    double best = numeric_limits<double>::infinity(); // the best time to a settled destination including its excess time
+    while (!pq.empty() && remaining > 0) {
+        pair<double, int> top = pq.pop();
+        int v = top.second;
+        if (W.isSettled(v)) continue; // a shorter time to v was already settled
+        if (!all && top.first >= best) break; // the bounds and excess times are non-negative, so no destination left can do better
+        last = top.first;
+        W.settle(v);
+        double time = W.getTime(v);
+        if (W.isTarget(v)) {
+            remaining--;
+            for (int d = 0; d < (int) destinations.size(); d++) {
+                if (destinations[d] == v) best = min(best, time + excessTime[d]);
+            }
+        }
+        for (int i = outStart[v]; i < outStart[v + 1]; i++) {
+            int e = outRoads[i];
+            int w = destination[e];
+            if (W.getTime(w) > time + expectedTime[e]) {
+                W.setTime(w, time + expectedTime[e], e);
+                pq.push(max(last, time + expectedTime[e] + estimate(w)), w);
             }
         }
     }
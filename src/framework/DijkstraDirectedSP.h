@@ -2,26 +2,29 @@
 #define DIJKSTRADIRECTEDSP_H_
 
 #include <vector>
-#include <unordered_map>
 #include "Forward.h"
 #include "RoadSegment.h"
 #include "Intersection.h"
 #include "WeightedDigraph.h"
+#include "RoutingWorkspace.h"
+#include "Landmarks.h"
 
 struct DijkstraDirectedSP {
 private:
-    std::unordered_map<int, double> timeTo;
-    std::unordered_map<int, RoadSegment*> roadTo;
     int shortestPathSourceID;
     int shortestPathDestinationID;
     double shortestTime;
     std::vector<RoadSegment*> shortestPath;
 
-    void dijkstra(WeightedDigraph *G, std::vector<int> &sourceIDs, std::vector<double> &initialTime);
+    DijkstraDirectedSP(CSRGraph *C, RoutingWorkspace &W, int destination, int destinationID, double initialTime, double excessTime);
+    static void dijkstra(CSRGraph *C, Landmarks *L, RoutingWorkspace &W, std::vector<int> &sources, std::vector<double> &initialTime, std::vector<int> &destinations, std::vector<double> &excessTime, bool all);
+    void readPath(CSRGraph *C, RoutingWorkspace &W, int destination);
 
 public:
     DijkstraDirectedSP(WeightedDigraph *G, std::vector<int> &sourceIDs, std::vector<double> &initialTime, std::vector<int> &destinationIDs, std::vector<double> &excessTime);
+    DijkstraDirectedSP(WeightedDigraph *G, std::vector<RoadSegment*> &sourceRoads, std::vector<double> &initialTime, std::vector<RoadSegment*> &destinationRoads, std::vector<double> &excessTime, double departureTime);
     ~DijkstraDirectedSP();
+    static std::vector<DijkstraDirectedSP*> fromSource(WeightedDigraph *G, int sourceID, std::vector<double> &initialTime, std::vector<int> &destinationIDs, std::vector<double> &excessTime);
     bool hasPath() const;
     double getShortestTime() const;
     int getSourceID() const;
@@ -9,5 +9,18 @@ struct Intersection;
 struct WeightedDigraph;
 struct DijkstraDirectedSP;
 struct Car;
+struct CarStore;
+struct CSRGraph;
+struct RoutingWorkspace;
+struct Landmarks;
+struct ContractionHierarchy;
+struct RoutingTable;
+struct RoutingTableCache;
+struct TravelTimes;
+struct MovementGraph;
+struct SignalSchedule;
+struct Route;
+struct RouteStore;
+struct SimulationContext;
 
 #endif
\ No newline at end of file
@@ -8,6 +8,19 @@
 #include "Intersection.h"
 #include "WeightedDigraph.h"
 #include "DijkstraDirectedSP.h"
+#include "CarStore.h"
+#include "CSRGraph.h"
+#include "RoutingWorkspace.h"
+#include "Landmarks.h"
+#include "ContractionHierarchy.h"
+#include "RoutingTable.h"
+#include "RoutingTableCache.h"
+#include "TravelTimes.h"
+#include "MovementGraph.h"
+#include "SignalSchedule.h"
+#include "Route.h"
+#include "RouteStore.h"
+#include "SimulationContext.h"
 #include "Car.h"
 
 #endif
@@ -1,51 +1,112 @@
 #include <assert.h>
 #include <algorithm>
 #include "Intersection.h"
+#include "WeightedDigraph.h"
+#include "SimulationContext.h"
 
 #define PI 3.14159265358979323846
 #define EPS 1e-9
 
 using namespace std;
 
-int Intersection::counter = 0; // counter starts at 0
-
 /**
  * Initializes a new intersection given an x, y coordianate in the 2-D cartesian plane.
+ * @param context the context that gives the intersection its ID
  * @param x the x-coordinate
  * @param y the y-coordinate
  */
-Intersection::Intersection(double x, double y) {
+Intersection::Intersection(SimulationContext *context, double x, double y) {
     this->location = Point2D(x, y);
-    id = Intersection::counter++; // assigns an id and increments the counter
+    this->context = context;
+    id = context->nextIntersectionID(); // assigns an id from the context
+    index = -1;
+    component = -1;
+    marked = false;
+    phase = -1;
     currentCycleNumber = 0;
     numberOfCycles = 0;
     leftTurn = false;
     timeOfLastCycle = 0.0;
+    totalDemand = 0;
+    compiled = false;
+    words = 0;
 }
 
 /**
  * Initializes a new intersection given a point in the 2-D cartesian plane.
+ * @param context the context that gives the intersection its ID
  * @param location the location of the intersection as a point
  */
-Intersection::Intersection(Point2D &location) {
+Intersection::Intersection(SimulationContext *context, Point2D &location) {
     this->location = Point2D(location.x, location.y);
-    id = counter++; // assigns an id and increments the counter
+    this->context = context;
+    id = context->nextIntersectionID(); // assigns an id from the context
+    index = -1;
+    component = -1;
+    marked = false;
+    phase = -1;
     currentCycleNumber = 0;
     numberOfCycles = 0;
     leftTurn = false;
     timeOfLastCycle = 0.0;
+    totalDemand = 0;
+    compiled = false;
+    words = 0;
 }
 
 /**
- * Deconstructs the Intersection
+ * Deconstructs the Intersection and the traffic lights that are still in it.
  */
-Intersection::~Intersection() {}
+Intersection::~Intersection() {
+    for (pair<const pair<int, int>, TrafficLight*> &l : lights) {
+        delete l.second;
+    }
+}
 
 /**
  * Returns the unique ID of this intersection.
  */
 int Intersection::getID() const { return id; }
 
+/**
+ * Returns the context the intersection belongs to.
+ */
+SimulationContext *Intersection::getContext() const { return context; }
+
+/**
+ * Returns the dense index of the intersection in the compiled graph, -1 if it has not been compiled.
+ */
+int Intersection::getIndex() const { return index; }
+
+/**
+ * Sets the dense index of the intersection in the compiled graph.
+ * @param index the index
+ */
+void Intersection::setIndex(int index) { this->index = index; }
+
+/**
+ * Returns the label of the strongly connected component of the intersection, which is only up to date when the
+ * graph is asked whether one intersection can be reached from another.
+ */
+int Intersection::getComponent() const { return component; }
+
+/**
+ * Sets the label of the strongly connected component of the intersection.
+ * @param component the label
+ */
+void Intersection::setComponent(int component) { this->component = component; }
+
+/**
+ * Returns true if the intersection is in the marked intersections of its graph, false otherwise.
+ */
+bool Intersection::isMarked() const { return marked; }
+
+/**
+ * Sets whether the intersection is in the marked intersections of its graph.
+ * @param marked true if the intersection was added to the list, false if it was taken out
+ */
+void Intersection::setMarked(bool marked) { this->marked = marked; }
+
 /**
  * Adds a RoadSegment to the intersection
  * @return false if the road segment is already in the intersection, true otherwise
@@ -65,6 +126,7 @@ bool Intersection::add(RoadSegment *r) {
     if (r->getDestination()->getID() != this->id && r->getSource()->getID() != this->id) {
         assert(false && "this road segment does not start or end at this intersection");
     }
+    if (compiled) compile(); // the new road segment needs a slot
     return true;
 }
 
@@ -150,6 +212,7 @@ bool Intersection::remove(RoadSegment *r) {
         }
         adjacentIn.erase(r->getID());
     }
+    if (compiled) compile(); // the slots of the remaining road segments change
     return true;
 }
 
@@ -162,6 +225,7 @@ bool Intersection::remove(RoadSegment *r) {
 void Intersection::connect(int from, int to, int type) {
     assert(inboundRoads.count(from) && "no inbound road exists in the intersection");
     assert(outboundRoads.count(to) && "no outbound road exists in the intersection");
+    compiled = false;
     adjacentOut[from].insert(to);
     adjacentIn[to].insert(from);
     TrafficLight *t = new TrafficLight(inboundRoads[from], outboundRoads[to], type);
@@ -182,6 +246,7 @@ void Intersection::connect(int from, int to, int type) {
  * @param B the ID of the other traffic light
  */
 void Intersection::link(int A, int B) {
+    compiled = false;
     int AType = lightFromID[A]->getType();
     assert(AType == STRAIGHT && "light A must be of type straight");
     int BType = lightFromID[B]->getType();
@@ -278,6 +343,95 @@ void Intersection::autoConnectAndLink() {
             }
         }
     }
+    compile();
+}
+
+/**
+ * Compiles the lights of the intersection into signal tables. The road segments get local slots, each traffic light
+ * becomes a movement in a dense turn matrix, and each cycle gets a bitset of its straight movements and of the left
+ * movements linked to them. The traffic lights are kept in sync with the bitset of green movements.
+ */
+void Intersection::compile() {
+    inSlots.clear();
+    outSlots.clear();
+    for (pair<int, RoadSegment*> in : inboundRoads) {
+        inSlots.push_back(in.second);
+    }
+    for (pair<int, RoadSegment*> out : outboundRoads) {
+        outSlots.push_back(out.second);
+    }
+    sort(inSlots.begin(), inSlots.end(), [](RoadSegment *a, RoadSegment *b) { return a->getID() < b->getID(); });
+    sort(outSlots.begin(), outSlots.end(), [](RoadSegment *a, RoadSegment *b) { return a->getID() < b->getID(); });
+    for (int i = 0; i < (int) inSlots.size(); i++) {
+        inSlots[i]->setInSlot(i);
+    }
+    for (int o = 0; o < (int) outSlots.size(); o++) {
+        outSlots[o]->setOutSlot(o);
+    }
+    unordered_map<int, int> movementOf; // maps the ID of the traffic light to its movement
+    turn.assign(inSlots.size() * outSlots.size(), -1);
+    movements.clear();
+    for (int i = 0; i < (int) inSlots.size(); i++) {
+        for (int o = 0; o < (int) outSlots.size(); o++) {
+            pair<int, int> p = make_pair(inSlots[i]->getID(), outSlots[o]->getID());
+            if (lights.count(p) == 0) continue;
+            turn[i * outSlots.size() + o] = movements.size();
+            movementOf[lights[p]->getID()] = movements.size();
+            movements.push_back(lights[p]);
+        }
+    }
+    words = (movements.size() + 63) / 64;
+    state.assign(words, 0);
+    for (int m = 0; m < (int) movements.size(); m++) {
+        if (movements[m]->getState() == GREEN) state[m / 64] |= 1ULL << (m % 64);
+    }
+    straightMask.assign(numberOfCycles * words, 0);
+    leftMask.assign(numberOfCycles * words, 0);
+    hasLeft.assign(numberOfCycles, false);
+    for (int k = 0; k < numberOfCycles; k++) {
+        for (int light : cycleToLight[k]) {
+            int m = movementOf[light];
+            straightMask[k * words + m / 64] |= 1ULL << (m % 64);
+            for (int left : linksLeft[light]) {
+                m = movementOf[left];
+                leftMask[k * words + m / 64] |= 1ULL << (m % 64);
+                hasLeft[k] = true;
+            }
+        }
+    }
+    cycleMask.assign(words, 0);
+    phaseMovements.assign(2 * numberOfCycles, vector<int>());
+    for (int k = 0; k < numberOfCycles; k++) {
+        for (int w = 0; w < words; w++) {
+            cycleMask[w] |= leftMask[k * words + w] | straightMask[k * words + w];
+        }
+        for (int m = 0; m < (int) movements.size(); m++) {
+            if ((leftMask[k * words + m / 64] >> (m % 64)) & 1) phaseMovements[2 * k].push_back(m);
+            if (((straightMask[k * words + m / 64] | leftMask[k * words + m / 64]) >> (m % 64)) & 1) phaseMovements[2 * k + 1].push_back(m);
+        }
+    }
+    vector<int> weight(inSlots.size() * numberOfCycles, 0); // the number of lights of each in-slot in each cycle
+    for (int k = 0; k < numberOfCycles; k++) {
+        for (int light : cycleToLight[k]) {
+            weight[lightFromID[light]->getFrom()->getInSlot() * numberOfCycles + k]++;
+        }
+    }
+    phaseStart.assign(1, 0);
+    phaseOf.clear();
+    phaseWeight.clear();
+    demand.assign(numberOfCycles, 0);
+    totalDemand = 0;
+    for (int i = 0; i < (int) inSlots.size(); i++) {
+        for (int k = 0; k < numberOfCycles; k++) {
+            if (weight[i * numberOfCycles + k] == 0) continue;
+            phaseOf.push_back(k);
+            phaseWeight.push_back(weight[i * numberOfCycles + k]);
+            demand[k] += weight[i * numberOfCycles + k] * inSlots[i]->getFlow();
+            totalDemand += weight[i * numberOfCycles + k] * inSlots[i]->getFlow();
+        }
+        phaseStart.push_back(phaseOf.size());
+    }
+    compiled = true;
 }
 
 /**
@@ -309,39 +463,90 @@ void Intersection::autoConnectAndLink() {
 }*/
 
 /**
- * Cycles the traffic lights in the intersection.
+ * Cycles the traffic lights in the intersection. The lights of the previous cycle turn red, then either the left
+ * lights linked to the current cycle turn green, or the straight lights of the current cycle turn green and the
+ * intersection moves on to the next cycle. Only the traffic lights that change are updated.
  */
 void Intersection::cycle(double time) {
+    if (!compiled) compile();
+    assert(numberOfCycles > 0);
     timeOfLastCycle = time;
-    unordered_set<int> greens;
-    unordered_set<int> lefts;
-    for (int light : cycleToLight[(currentCycleNumber + numberOfCycles - 1) % numberOfCycles]) {
-        lightFromID[light]->setState(RED);
-        for (int left : linksLeft[light]) {
-            lightFromID[left]->setState(RED);
-        }
+    int previous = (currentCycleNumber + numberOfCycles - 1) % numberOfCycles;
+    bool left = !leftTurn && hasLeft[currentCycleNumber];
+    const unsigned long long *on = left ? &leftMask[currentCycleNumber * words] : &straightMask[currentCycleNumber * words];
+    for (int w = 0; w < words; w++) {
+        setState(w, (state[w] & ~(straightMask[previous * words + w] | leftMask[previous * words + w])) | on[w]);
     }
-    for (int light : cycleToLight[currentCycleNumber]) {
-        greens.insert(light);
-        if (!leftTurn) {
-            for (int left : linksLeft[light]) {
-                lefts.insert(left);
-            }
-        }
+    leftTurn = left;
+    phase = 2 * currentCycleNumber + (left ? 0 : 1);
+    if (!left) currentCycleNumber = (currentCycleNumber + 1) % numberOfCycles;
+}
+
+/**
+ * Sets one word of the bitset of green movements, and updates the traffic lights that change.
+ * @param w the index of the word
+ * @param next the new bits of the word
+ */
+void Intersection::setState(int w, unsigned long long next) {
+    for (unsigned long long changed = next ^ state[w]; changed != 0; changed &= changed - 1) {
+        int m = w * 64 + __builtin_ctzll(changed);
+        movements[m]->setState((next >> (m % 64)) & 1 ? GREEN : RED);
     }
-    assert(greens.size() > 0);
-    if (lefts.size() == 0) {
-        leftTurn = false;
-        for (int light : greens) {
-            lightFromID[light]->setState(GREEN);
-        }
-        currentCycleNumber = (currentCycleNumber + 1) % numberOfCycles;
-    } else {
-        leftTurn = true;
-        for (int light : lefts) {
-            lightFromID[light]->setState(GREEN);
-        }
+    state[w] = next;
+}
+
+/**
+ * Returns the number of phases of the intersection, two for each cycle. Phase 2k turns on the left lights linked to
+ * cycle k and phase 2k + 1 turns on the straight lights of cycle k, as cycle() does in turn.
+ */
+int Intersection::countPhases() {
+    if (!compiled) compile();
+    return 2 * numberOfCycles;
+}
+
+/**
+ * Returns true if a phase turns on any lights, false otherwise. Cycles without left lights have no left phase.
+ * @param p the phase
+ */
+bool Intersection::hasPhase(int p) {
+    if (!compiled) compile();
+    assert(p >= 0 && p < 2 * numberOfCycles && "phase is not valid");
+    return !phaseMovements[p].empty();
+}
+
+/**
+ * Returns the movements that a phase turns on, as indices in getMovements().
+ * @param p the phase
+ */
+const vector<int> &Intersection::getPhaseMovements(int p) {
+    if (!compiled) compile();
+    assert(p >= 0 && p < 2 * numberOfCycles && "phase is not valid");
+    return phaseMovements[p];
+}
+
+/**
+ * Returns the phase that was turned on last by cycle() or setPhase(), or -1 if the lights were never changed.
+ */
+int Intersection::getCurrentPhase() const { return phase; }
+
+/**
+ * Turns on the lights of a phase and turns off the lights of every other phase. Lights that are not in any cycle
+ * are left as they are. A later call to cycle() carries on from the phase.
+ * @param p the phase, which must turn on some lights
+ * @param time the current time
+ */
+void Intersection::setPhase(int p, double time) {
+    assert(hasPhase(p) && "phase does not turn on any lights");
+    timeOfLastCycle = time;
+    int k = p / 2;
+    bool left = p % 2 == 0;
+    for (int w = 0; w < words; w++) {
+        unsigned long long on = left ? leftMask[k * words + w] : straightMask[k * words + w] | leftMask[k * words + w];
+        setState(w, (state[w] & ~cycleMask[w]) | on);
     }
+    leftTurn = left;
+    phase = p;
+    currentCycleNumber = left ? k : (k + 1) % numberOfCycles;
 }
 
 /**
@@ -358,25 +563,55 @@ bool Intersection::leftTurnSignalOn() const { return leftTurn; }
  * Returns the flow of vehicles in incoming roads that are green.
  */
 int Intersection::getCurrentFlow() {
-    int flow = 0;
-    for (int t : cycleToLight[currentCycleNumber]) {
-        flow += lightFromID[t]->getFrom()->getFlow();
-    }
-    return flow;
+    if (!compiled) compile();
+    return demand[currentCycleNumber];
 }
 
 /**
  * Returns the flow of vehicles in incoming roads that are red.
  */
 int Intersection::getOppositeFlow() {
-    int flow = 0;
-    for (int i = 0; i < numberOfCycles; i++) {
-        if (i == currentCycleNumber) continue;
-        for (int t : cycleToLight[currentCycleNumber]) {
-            flow += lightFromID[t]->getFrom()->getFlow();
-        }
+    if (!compiled) compile();
+    return totalDemand - demand[currentCycleNumber];
+}
+
+/**
+ * Returns the demand of a cycle, which is the number of vehicles on the inbound road segments of its lights.
+ * A road segment is counted once for each of its lights in the cycle. The demand is kept up to date as the flow of
+ * the inbound road segments changes, so it is read in constant time.
+ * @param k the cycle number
+ */
+int Intersection::getPhaseDemand(int k) {
+    if (!compiled) compile();
+    assert(k >= 0 && k < numberOfCycles && "cycle number is not valid");
+    return demand[k];
+}
+
+/**
+ * Returns the demand of a movement, which is the number of vehicles on the road segment it leads from.
+ * @param m the index of the movement in getMovements()
+ */
+int Intersection::getMovementDemand(int m) {
+    if (!compiled) compile();
+    assert(m >= 0 && m < (int) movements.size() && "movement is not valid");
+    return movements[m]->getFrom()->getFlow();
+}
+
+/**
+ * Updates the demand of the cycles after the flow of an inbound road segment changed, and marks the intersection in
+ * its graph so a controller can check it again. The demand is counted again when the signal tables are compiled, so
+ * changes before then are ignored.
+ * @param r the inbound road segment
+ * @param change the change in the flow of the road segment
+ */
+void Intersection::updateDemand(RoadSegment *r, int change) {
+    if (!compiled) return;
+    int i = r->getInSlot();
+    for (int j = phaseStart[i]; j < phaseStart[i + 1]; j++) {
+        demand[phaseOf[j]] += change * phaseWeight[j];
+        totalDemand += change * phaseWeight[j];
     }
-    return flow;
+    if (r->getGraph() != nullptr) r->getGraph()->markIntersection(this);
 }
 
 /**
@@ -433,6 +668,84 @@ TrafficLight *Intersection::getLightBetween(int from, int to) {
     return lights[p];
 }
 
+/**
+ * Returns true if the light between two road segments of the intersection is green, false otherwise (or if there is
+ * no light between them). The signal tables must be compiled (autoConnectAndLink() compiles them).
+ * @param from the inbound road segment
+ * @param to the outbound road segment
+ */
+bool Intersection::isGreen(const RoadSegment *from, const RoadSegment *to) const {
+    assert(compiled && "the signal tables are not compiled");
+    assert(from->getDestination() == this && to->getSource() == this && "one of the roads is not in the intersection");
+    int m = turn[from->getInSlot() * outSlots.size() + to->getOutSlot()];
+    return m >= 0 && ((state[m / 64] >> (m % 64)) & 1);
+}
+
+/**
+ * Returns a reference to the traffic lights of the intersection, in order of the IDs of their inbound and then their
+ * outbound road segments. The signal tables are compiled first if they are not up to date.
+ */
+const vector<TrafficLight*> &Intersection::getMovements() {
+    if (!compiled) compile();
+    return movements;
+}
+
+/**
+ * Computes when each traffic light is green if the intersection is cycled from its first cycle at fixed intervals:
+ * each left phase lasts leftTime, and each straight phase lasts straightTime less the left phase before it. The same
+ * steps as cycle() are followed on a copy of the signal tables for one period, after which the lights repeat.
+ * Lights that are never cycled (right turns) keep their current state.
+ * @param leftTime the duration of a left phase
+ * @param straightTime the duration of a left phase and the straight phase after it, or of a straight phase alone
+ * @param green the vector the green intervals of each traffic light are written to, in the order of getMovements(),
+ * as times since the start of the period
+ * @return the period of the signal plan, 0 if the intersection has no cycles (its green lights are then always green)
+ */
+double Intersection::getSignalPlan(double leftTime, double straightTime, vector<vector<pair<double, double>>> &green) {
+    if (!compiled) compile();
+    green.assign(movements.size(), vector<pair<double, double>>());
+    if (numberOfCycles == 0) {
+        for (int m = 0; m < (int) movements.size(); m++) {
+            if ((state[m / 64] >> (m % 64)) & 1) green[m].push_back(make_pair(0.0, 0.0));
+        }
+        return 0.0;
+    }
+    vector<unsigned long long> on(words, 0), all(words, 0);
+    for (int k = 0; k < numberOfCycles; k++) {
+        for (int w = 0; w < words; w++) {
+            all[w] |= straightMask[k * words + w] | leftMask[k * words + w];
+        }
+    }
+    for (int w = 0; w < words; w++) {
+        on[w] = state[w] & ~all[w];
+    }
+    vector<double> since(movements.size(), 0.0); // the time each green light turned green
+    double time = 0.0;
+    int current = 0;
+    bool left = false;
+    do {
+        int previous = (current + numberOfCycles - 1) % numberOfCycles;
+        bool nextLeft = !left && hasLeft[current];
+        const unsigned long long *mask = nextLeft ? &leftMask[current * words] : &straightMask[current * words];
+        for (int w = 0; w < words; w++) {
+            unsigned long long next = (on[w] & ~(straightMask[previous * words + w] | leftMask[previous * words + w])) | mask[w];
+            for (unsigned long long changed = next ^ on[w]; changed != 0; changed &= changed - 1) {
+                int m = w * 64 + __builtin_ctzll(changed);
+                if ((next >> (m % 64)) & 1) since[m] = time;
+                else if (since[m] < time) green[m].push_back(make_pair(since[m], time));
+            }
+            on[w] = next;
+        }
+        time += nextLeft ? leftTime : straightTime - (left ? leftTime : 0.0);
+        left = nextLeft;
+        if (!left) current = (current + 1) % numberOfCycles;
+    } while (current != 0 || left);
+    for (int m = 0; m < (int) movements.size(); m++) {
+        if ((on[m / 64] >> (m % 64)) & 1) green[m].push_back(make_pair(since[m], time)); // turned red by the first step of the next period
+    }
+    return time;
+}
+
 /**
  * Returns a pointer to the road that leads from the intersection with the specified ID.
  */
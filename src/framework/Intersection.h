@@ -4,6 +4,7 @@
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
+#include "Forward.h"
 #include "Point2D.h"
 #include "RoadSegment.h"
 #include "TrafficLight.h"
@@ -11,8 +12,11 @@
 
 struct Intersection {
 private:
-    static int counter; // number of intersections that have been created
+    SimulationContext *context; // the context the intersection belongs to
     int id; // each intersection has a unique id number
+    int index; // the dense index of the intersection in the compiled graph
+    int component; // the label of the strongly connected component of the intersection in its graph
+    bool marked; // whether the intersection is in the marked intersections of its graph
     bool leftTurn; // whether there is a left turn signal on
     std::unordered_map<int, RoadSegment*> inboundRoads; // inbound road segments
     std::unordered_map<int, RoadSegment*> outboundRoads; // outbound road segments
@@ -33,14 +37,41 @@ private:
     std::vector<std::unordered_set<int>> cycleToLight; // the set of lights associated with the cycle number
     std::unordered_map<int, int> cycleNumber; // cycle number of a light
     double timeOfLastCycle;
+    bool compiled; // whether the signal tables below are up to date
+    std::vector<RoadSegment*> inSlots; // the inbound road segments in order of ID, indexed by local in-slot
+    std::vector<RoadSegment*> outSlots; // the outbound road segments in order of ID, indexed by local out-slot
+    std::vector<int> turn; // the movement for each pair of in-slot and out-slot (in-slot * number of out-slots + out-slot), -1 if none
+    std::vector<TrafficLight*> movements; // the traffic light of each movement
+    int words; // the number of 64-bit words in each bitset of movements
+    std::vector<unsigned long long> state; // the bitset of the movements that are green
+    std::vector<unsigned long long> straightMask; // the bitset of the straight movements of each cycle, words per cycle
+    std::vector<unsigned long long> leftMask; // the bitset of the left movements linked to each cycle, words per cycle
+    std::vector<char> hasLeft; // whether each cycle has left movements
+    std::vector<unsigned long long> cycleMask; // the bitset of the movements in any cycle, which the phases turn on and off
+    std::vector<std::vector<int>> phaseMovements; // the movements of each phase, 2k for the left lights of cycle k and 2k + 1 for its straight lights
+    int phase; // the phase that was turned on last, -1 if none
+    std::vector<int> phaseStart; // the cycles of in-slot i are phaseOf[phaseStart[i]..phaseStart[i + 1])
+    std::vector<int> phaseOf; // the cycles that the lights of each in-slot belong to, grouped by in-slot
+    std::vector<int> phaseWeight; // the number of lights of the in-slot in each of those cycles
+    std::vector<int> demand; // the vehicles on the inbound road segments of each cycle, counted once per light of the cycle
+    int totalDemand; // the sum of the demand of every cycle
 
     // void dfs(int light, int cur);
+    void compile();
+    void setState(int w, unsigned long long next);
 
 public:
-    Intersection(double x, double y);
-    Intersection(Point2D &location);
+    Intersection(SimulationContext *context, double x, double y);
+    Intersection(SimulationContext *context, Point2D &location);
     ~Intersection();
     int getID() const;
+    SimulationContext *getContext() const;
+    int getIndex() const;
+    void setIndex(int index);
+    int getComponent() const;
+    void setComponent(int component);
+    bool isMarked() const;
+    void setMarked(bool marked);
     bool add(RoadSegment *r);
     bool remove(RoadSegment *r);
     void connect(int from, int to, int type);
@@ -50,8 +81,16 @@ public:
     void cycle(double time);
     int getCurrentCycle() const;
     bool leftTurnSignalOn() const;
+    int countPhases();
+    bool hasPhase(int p);
+    const std::vector<int> &getPhaseMovements(int p);
+    int getCurrentPhase() const;
+    void setPhase(int p, double time);
     int getCurrentFlow();
     int getOppositeFlow();
+    int getPhaseDemand(int k);
+    int getMovementDemand(int m);
+    void updateDemand(RoadSegment *r, int change);
     double getTimeOfLastCycle() const;
     int outdegree() const;
     int indegree() const;
@@ -61,6 +100,9 @@ public:
     const std::unordered_map<int, Intersection*> &getOutboundIntersections() const;
     bool isConnected(int from, int to);
     TrafficLight *getLightBetween(int from, int to);
+    bool isGreen(const RoadSegment *from, const RoadSegment *to) const;
+    const std::vector<TrafficLight*> &getMovements();
+    double getSignalPlan(double leftTime, double straightTime, std::vector<std::vector<std::pair<double, double>>> &green);
     RoadSegment *getRoadFrom(int id);
     RoadSegment *getRoadTo(int id);
     Point2D getLocation() const;
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <assert.h>
+#include "Landmarks.h"
+#include "CSRGraph.h"
+#include "Intersection.h"
+#include "../misc/RadixHeap.h"
+
+using namespace std;
+
+/**
+ * Chooses the landmarks of a compiled graph by farthest point selection and stores the times from and to each of them.
+ * The first landmark is the intersection farthest from intersection 0, and each landmark after it is the intersection
+ * farthest from the landmarks already chosen, where the distance is the round trip time. Intersections that cannot
+ * make the round trip to a landmark are the farthest of all, so every strongly connected part of the city is covered.
+ * @param C the compiled graph
+ * @param count the number of landmarks to choose (fewer are chosen if the graph is smaller)
+ */
+Landmarks::Landmarks(CSRGraph *C, int count) {
+    assert(count > 0 && "count must be a positive value");
+    int n = C->countIntersections();
+    maxSpeedLimit = 0.0;
+    for (double s : C->getSpeedLimits()) {
+        maxSpeedLimit = max(maxSpeedLimit, s);
+    }
+    for (int v = 0; v < n; v++) {
+        x.push_back(C->getIntersection(v)->getLocation().x);
+        y.push_back(C->getIntersection(v)->getLocation().y);
+    }
+    vector<vector<double>> from, to; // the times from and to each landmark, indexed by landmark then intersection
+    vector<double> nearest(n, numeric_limits<double>::infinity()); // the round trip time to the nearest landmark
+    vector<double> first, second;
+    int next = 0;
+    if (n > 0) {
+        search(C, 0, false, first);
+        search(C, 0, true, second);
+        for (int v = 0; v < n; v++) {
+            if (first[v] + second[v] > first[next] + second[next]) next = v;
+        }
+    }
+    while ((int) landmarks.size() < count && (int) landmarks.size() < n && nearest[next] > 0.0) {
+        landmarks.push_back(next);
+        from.emplace_back();
+        to.emplace_back();
+        search(C, next, false, from.back());
+        search(C, next, true, to.back());
+        for (int v = 0; v < n; v++) {
+            nearest[v] = min(nearest[v], from.back()[v] + to.back()[v]);
+        }
+        next = 0;
+        for (int v = 1; v < n; v++) {
+            if (nearest[v] > nearest[next]) next = v;
+        }
+    }
+    this->count = landmarks.size();
+    timeFrom.resize((size_t) n * this->count);
+    timeTo.resize((size_t) n * this->count);
+    for (int v = 0; v < n; v++) { // the times of an intersection are contiguous, since they are read together
+        for (int l = 0; l < this->count; l++) {
+            timeFrom[(size_t) v * this->count + l] = from[l][v];
+            timeTo[(size_t) v * this->count + l] = to[l][v];
+        }
+    }
+}
+
+/**
+ * Deconstructs the landmarks.
+ */
+Landmarks::~Landmarks() {}
+
+/**
+ * Finds the time at the speed limit from a source to every intersection, or from every intersection to the source.
+ * @param C the compiled graph
+ * @param source the index of the source intersection
+ * @param reverse true to follow the road segments backwards, false otherwise
+ * @param time the vector to fill with the time of each intersection, infinity if there is no path
+ */
+void Landmarks::search(CSRGraph *C, int source, bool reverse, vector<double> &time) {
+    const vector<int> &start = reverse ? C->getInStart() : C->getOutStart();
+    const vector<int> &roads = reverse ? C->getInRoads() : C->getOutRoads();
+    const vector<int> &other = reverse ? C->getSources() : C->getDestinations();
+    const vector<double> &expectedTime = C->getExpectedTimes();
+    time.assign(C->countIntersections(), numeric_limits<double>::infinity());
+    RadixHeap pq;
+    time[source] = 0.0;
+    pq.push(0.0, source);
+    while (!pq.empty()) {
+        pair<double, int> top = pq.pop();
+        int v = top.second;
+        if (top.first > time[v]) continue;
+        for (int i = start[v]; i < start[v + 1]; i++) {
+            int e = roads[i];
+            int w = other[e];
+            if (time[w] > top.first + expectedTime[e]) {
+                time[w] = top.first + expectedTime[e];
+                pq.push(time[w], w);
+            }
+        }
+    }
+}
+
+/**
+ * Returns the number of landmarks.
+ */
+int Landmarks::countLandmarks() const { return count; }
+
+/**
+ * Returns an immutable reference to the indices of the landmark intersections.
+ */
+const vector<int> &Landmarks::getLandmarks() const { return landmarks; }
+
+/**
+ * Returns a lower bound on the time at the speed limit from one intersection to another.
+ * Landmarks that cannot reach or be reached from either intersection give no bound and are skipped.
+ * @param v the index of the intersection to start from
+ * @param t the index of the intersection to reach
+ */
+double Landmarks::lowerBound(int v, int t) const {
+    double bound = 0.0;
+    if (maxSpeedLimit > 0.0) {
+        double dx = x[v] - x[t], dy = y[v] - y[t];
+        bound = sqrt(dx * dx + dy * dy) / maxSpeedLimit;
+    }
+    const double infinity = numeric_limits<double>::infinity();
+    const double *fromV = timeFrom.data() + (size_t) v * count, *fromT = timeFrom.data() + (size_t) t * count;
+    const double *toV = timeTo.data() + (size_t) v * count, *toT = timeTo.data() + (size_t) t * count;
+    for (int l = 0; l < count; l++) {
+        if (fromT[l] != infinity && fromV[l] != infinity) bound = max(bound, fromT[l] - fromV[l]); // L -> v -> t
+        if (toV[l] != infinity && toT[l] != infinity) bound = max(bound, toV[l] - toT[l]); // v -> t -> L
+    }
+    return bound;
+}
@@ -0,0 +1,35 @@
+#ifndef LANDMARKS_H_
+#define LANDMARKS_H_
+
+#include <vector>
+#include "Forward.h"
+
+#define LANDMARKS 8 // the number of landmarks chosen in a network
+
+/**
+ * The landmarks of the A* search with landmarks and the triangle inequality (ALT). A few intersections spread around
+ * the edge of the network are chosen, and the times from and to each of them are stored for every intersection.
+ * The time between two intersections is then bounded from below by the triangle inequality, and by the straight line
+ * distance at the fastest speed limit. Both bounds are consistent, so A* settles every intersection once.
+ */
+struct Landmarks {
+private:
+    int count; // the number of landmarks
+    std::vector<int> landmarks; // the index of each landmark intersection
+    std::vector<double> timeFrom; // timeFrom[v * count + l] is the time from landmark l to intersection v
+    std::vector<double> timeTo; // timeTo[v * count + l] is the time from intersection v to landmark l
+    std::vector<double> x; // the x-coordinate of each intersection
+    std::vector<double> y; // the y-coordinate of each intersection
+    double maxSpeedLimit; // the fastest speed limit of any road segment
+
+    static void search(CSRGraph *C, int source, bool reverse, std::vector<double> &time);
+
+public:
+    Landmarks(CSRGraph *C, int count);
+    ~Landmarks();
+    int countLandmarks() const;
+    const std::vector<int> &getLandmarks() const;
+    double lowerBound(int v, int t) const;
+};
+
+#endif
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <limits>
+#include <assert.h>
+#include "MovementGraph.h"
+#include "CSRGraph.h"
+#include "Intersection.h"
+#include "TrafficLight.h"
+#include "RoutingWorkspace.h"
+
+using namespace std;
+
+/**
+ * Builds the movement graph from the compiled signal tables of the intersections, grouping the movements by the
+ * road segment they leave with a counting sort.
+ * @param C the compiled graph
+ * @param penalty the penalty of each type of movement, indexed by type
+ */
+MovementGraph::MovementGraph(CSRGraph *C, const vector<double> &penalty) {
+    assert(penalty.size() == UTURN + 1 && "there must be a penalty for each type of movement");
+    this->C = C;
+    this->penalty = penalty;
+    int m = C->countRoadSegments(), total = 0;
+    start.assign(m + 1, 0);
+    for (Intersection *v : C->getIntersections()) {
+        for (TrafficLight *t : v->getMovements()) {
+            start[t->getFrom()->getIndex() + 1]++;
+            total++;
+        }
+    }
+    for (int e = 0; e < m; e++) {
+        start[e + 1] += start[e];
+    }
+    to.resize(total);
+    type.resize(total);
+    vector<int> next(start.begin(), start.end() - 1);
+    for (Intersection *v : C->getIntersections()) {
+        for (TrafficLight *t : v->getMovements()) {
+            int j = next[t->getFrom()->getIndex()]++;
+            to[j] = t->getTo()->getIndex();
+            type[j] = t->getType();
+        }
+    }
+}
+
+/**
+ * Deconstructs the movement graph.
+ */
+MovementGraph::~MovementGraph() {}
+
+/**
+ * Returns the number of movements.
+ */
+int MovementGraph::countMovements() const { return to.size(); }
+
+/**
+ * Returns a reference to the offsets of the movements out of each road segment, indexed by road segment.
+ */
+const vector<int> &MovementGraph::getStart() const { return start; }
+
+/**
+ * Returns a reference to the road segment each movement leads to.
+ */
+const vector<int> &MovementGraph::getTargets() const { return to; }
+
+/**
+ * Returns a reference to the type of each movement.
+ */
+const vector<char> &MovementGraph::getTypes() const { return type; }
+
+/**
+ * Returns the penalty of a type of movement in seconds.
+ * @param type LEFT, STRAIGHT, RIGHT or UTURN
+ */
+double MovementGraph::getPenalty(int type) const {
+    assert(type >= 0 && type < (int) penalty.size() && "type is not valid");
+    return penalty[type];
+}
+
+/**
+ * Sets the penalty of a type of movement.
+ * @param type LEFT, STRAIGHT, RIGHT or UTURN
+ * @param penalty the penalty in seconds (must be a non-negative value)
+ */
+void MovementGraph::setPenalty(int type, double penalty) {
+    assert(type >= 0 && type < (int) this->penalty.size() && "type is not valid");
+    assert(penalty >= 0.0 && "penalty must be a non-negative value");
+    this->penalty[type] = penalty;
+}
+
+/**
+ * Finds the fastest route from the end of one of the source road segments to a point on one of the destination road
+ * segments with Dijkstra's algorithm over the movements, in the workspace of the calling thread. The time to a road
+ * segment is the time to reach its end. A destination road segment is reached through a movement into it, and is not
+ * searched any further. The search stops once no road segment left can beat the best destination.
+ * @param sources the indices of the road segments the route can start on
+ * @param initialTime the time to reach the end of each source road segment
+ * @param destinations the indices of the road segments the route can finish on
+ * @param excessTime the time from the start of each destination road segment to the destination
+ * @param source the position of the chosen source in sources, -1 if there is no route
+ * @param destination the position of the chosen destination in destinations, -1 if there is no route
+ * @param path the vector the road segments between the source and destination road segments are written to
+ * @return the time of the route including the penalties, infinity if there is no route
+ */
+double MovementGraph::route(const vector<int> &sources, const vector<double> &initialTime, const vector<int> &destinations, const vector<double> &excessTime, int &source, int &destination, vector<RoadSegment*> &path) const {
+    const vector<double> &expectedTime = C->getExpectedTimes();
+    RoutingWorkspace &W = RoutingWorkspace::local();
+    W.reset(C->countRoadSegments());
+    RadixHeap &pq = W.getHeap();
+    for (int e : destinations) {
+        W.markTarget(e);
+    }
+    for (int s = 0; s < (int) sources.size(); s++) {
+        if (initialTime[s] >= W.getTime(sources[s])) continue;
+        W.setTime(sources[s], initialTime[s], -1);
+        pq.push(initialTime[s], sources[s]);
+    }
+    double best = numeric_limits<double>::infinity();
+    int last = -1; // the road segment before the best destination
+    destination = -1;
+    while (!pq.empty()) {
+        pair<double, int> top = pq.pop();
+        int e = top.second;
+        if (W.isSettled(e)) continue; // a shorter time to e was already settled
+        if (top.first >= best) break; // the penalties and excess times are non-negative, so no destination left can do better
+        W.settle(e);
+        for (int j = start[e]; j < start[e + 1]; j++) {
+            int f = to[j];
+            double time = top.first + penalty[type[j]];
+            if (W.isTarget(f)) {
+                for (int d = 0; d < (int) destinations.size(); d++) {
+                    if (destinations[d] == f && time + excessTime[d] < best) {
+                        best = time + excessTime[d];
+                        last = e;
+                        destination = d;
+                    }
+                }
+            } else if (W.getTime(f) > time + expectedTime[f]) {
+                W.setTime(f, time + expectedTime[f], e);
+                pq.push(time + expectedTime[f], f);
+            }
+        }
+    }
+    path.clear();
+    source = -1;
+    if (last == -1) return best;
+    int e = last;
+    for (; W.getRoad(e) != -1; e = W.getRoad(e)) {
+        path.push_back(C->getRoadSegment(e));
+    }
+    reverse(path.begin(), path.end());
+    for (int s = 0; s < (int) sources.size() && source == -1; s++) {
+        if (sources[s] == e) source = s;
+    }
+    return best;
+}
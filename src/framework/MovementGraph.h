@@ -0,0 +1,40 @@
+#ifndef MOVEMENTGRAPH_H_
+#define MOVEMENTGRAPH_H_
+
+#include <vector>
+#include "Forward.h"
+
+// the default penalty of each type of movement, the expected wait at its traffic light in seconds
+#define TURN_PENALTY_LEFT 15.0
+#define TURN_PENALTY_STRAIGHT 5.0
+#define TURN_PENALTY_RIGHT 5.0
+#define TURN_PENALTY_UTURN 30.0
+
+/**
+ * The line graph of a compiled graph, built from the traffic lights of the intersections. Each road segment is a
+ * vertex, and each traffic light is an arc (a movement) from its inbound to its outbound road segment, so a route in
+ * this graph only takes turns the intersections allow. A movement costs the penalty of its type plus the time to
+ * travel the road segment it leads to. Only the target and the type of each movement are stored, grouped by the
+ * road segment they leave, and the penalties are looked up by type so they can be changed without a rebuild.
+ */
+struct MovementGraph {
+private:
+    CSRGraph *C; // the compiled graph
+    std::vector<int> start; // the movements out of road segment e are to[start[e]..start[e + 1])
+    std::vector<int> to; // the index of the road segment each movement leads to
+    std::vector<char> type; // the type of each movement (LEFT, STRAIGHT, RIGHT or UTURN)
+    std::vector<double> penalty; // the penalty of each type of movement
+
+public:
+    MovementGraph(CSRGraph *C, const std::vector<double> &penalty);
+    ~MovementGraph();
+    int countMovements() const;
+    const std::vector<int> &getStart() const;
+    const std::vector<int> &getTargets() const;
+    const std::vector<char> &getTypes() const;
+    double getPenalty(int type) const;
+    void setPenalty(int type, double penalty);
+    double route(const std::vector<int> &sources, const std::vector<double> &initialTime, const std::vector<int> &destinations, const std::vector<double> &excessTime, int &source, int &destination, std::vector<RoadSegment*> &path) const;
+};
+
+#endif
@@ -1,16 +1,14 @@
 #include <assert.h>
 #include <cmath>
-#include <ctime>
-#include <random>
 #include "RoadSegment.h"
+#include "WeightedDigraph.h"
+#include "SimulationContext.h"
 
 using namespace std;
 
-int RoadSegment::counter = 0; // counter starts at 0
-
 /**
  * Initalizes the RoadSegment with values
- * @param source the source intersection
+ * @param source the source intersection (must belong to the same context as the destination)
  * @param destination the destination intersection
  * @param speedLimit the speed limit of the road segment (must be a positive value)
  * @param capacity the maximum number of vehicles on the road segment (must be a non-negative integer)
@@ -20,28 +18,49 @@ RoadSegment::RoadSegment(Intersection *source, Intersection *destination, double
     assert(capacity >= 0 && "capacity must be a non-negative integer");
     this->source = source; // the intersections sould be pointers, not copies
     this->destination = destination;
-    id = counter++; // assigns an id and increments the counter
+    id = source->getContext()->nextRoadSegmentID(); // assigns an id from the context of the intersections
+    index = -1;
     Point2D srcLoc = source->getLocation(), destLoc = destination->getLocation();
     this->length = srcLoc.distanceTo(destLoc);
+    directionX = length > 0.0 ? (destLoc.x - srcLoc.x) / length : 0.0;
+    directionY = length > 0.0 ? (destLoc.y - srcLoc.y) / length : 0.0;
     this->speedLimit = speedLimit;
     this->flow = 0;
     this->capacity = capacity;
+    graph = nullptr;
+    cars.resize(capacity);
+    front = 0;
+    queued = 0;
     latestTime = 0.0;
+    activeIndex = -1;
+    inSlot = -1;
+    outSlot = -1;
+    waitingFor = AWAKE;
+    waitingRoad = nullptr;
 }
 
 /**
- * Deconstructs the Road Segment and detaches it from the intersection
+ * Deconstructs the Road Segment. It is detached from its intersections when it is removed from its graph, and the
+ * graph deletes its road segments along with their intersections when it is deconstructed.
  */
-RoadSegment::~RoadSegment() {
-    source->remove(this);
-    destination->remove(this);
-}
+RoadSegment::~RoadSegment() {}
 
 /**
  * Returns the unique ID of the road segment.
  */
 int RoadSegment::getID() const { return id; }
 
+/**
+ * Returns the dense index of the road segment in the compiled graph, -1 if it has not been compiled.
+ */
+int RoadSegment::getIndex() const { return index; }
+
+/**
+ * Sets the dense index of the road segment in the compiled graph.
+ * @param index the index
+ */
+void RoadSegment::setIndex(int index) { this->index = index; }
+
 /**
  * Returns the source intersection of the road segment.
  */
@@ -52,6 +71,17 @@ Intersection *RoadSegment::getSource() const { return source; }
  */
 Intersection *RoadSegment::getDestination() const { return destination; }
 
+/**
+ * Returns the graph the road segment is in.
+ */
+WeightedDigraph *RoadSegment::getGraph() const { return graph; }
+
+/**
+ * Sets the graph the road segment is in.
+ * @param G the Weighted Directed Graph
+ */
+void RoadSegment::setGraph(WeightedDigraph *G) { graph = G; }
+
 /**
  * Returns the length of the road segment.
  */
@@ -88,63 +118,104 @@ double RoadSegment::getProjectedSpeed() const {
 
 /**
  * Returns a random speed of cars on this road with a mean equal to the projected speed and standard deviation of 20% of the projected speed.
+ * The speed is drawn from a stream keyed by the car and its index on its path, so it only depends on the run seed.
+ * @param c the pointer to the car
  */
-double RoadSegment::getRandomSpeed() const {
-    default_random_engine generator(time(0));
+double RoadSegment::getRandomSpeed(const Car *c) const {
+    RandomStream random(graph->getSeed(), STREAM_SPEED, c->getID(), graph->getCarStore()->getPathIndices()[c->getHandle().index]);
     double proj = getProjectedSpeed();
-    normal_distribution<double> distribution(proj, proj * 0.2);
-    return min(max(MIN_SPEED, distribution(generator)), speedLimit);
+    return min(max(MIN_SPEED, random.nextNormal(proj, proj * 0.2)), speedLimit);
 }
 
 /**
  * Adds the specified amount of flow to the road segment. The value added must be non-negative and the flow cannot exceed the capacity.
+ * The demand counters of the destination intersection are updated.
  * @param value the amount of flow to be added (a positve value)
  */
 void RoadSegment::addFlow(int value) {
     assert(value >= 0 && "value must be non-negative");
     assert(flow + value <= capacity && "flow cannot exceed capacity");
     flow += value;
+    destination->updateDemand(this, value);
 }
 
 /**
  * Subtracts the specified amount of flow to the road segment. The value substracted must be non-negative and the flow cannot become negative.
+ * The demand counters of the destination intersection are updated.
  * @param value the amount of flow to be subtracted (a positive value)
  */
 void RoadSegment::subtractFlow(int value) {
     assert(value >= 0 && "value must be non-negative");
     assert(flow - value >= 0 && "flow cannot become negative");
     flow -= value;
+    destination->updateDemand(this, -value);
 }
 
 /**
- * Adds a car to the road segment.
- * Returns true if the car was added, false otherwise (car was already on the road).
+ * Returns a reference to the handle of the car that is i-th closest to the destination.
+ * @param i the index of the car (0 is the car closest to the destination)
+ */
+CarHandle &RoadSegment::at(int i) { return cars[(front + i) % capacity]; }
+
+/**
+ * Adds a car to the road segment at a position along it. The cars stay ordered by position, and a car placed
+ * ahead of a car in the waiting queue joins the queue.
+ * Returns true if the car was added, false otherwise (car was already on the road or the road is full).
  * @param c the pointer to the car
+ * @param position the distance from the source of the road segment to the car (0 if the car enters from the source)
  */
-bool RoadSegment::addCar(Car *c) {
+bool RoadSegment::addCar(Car *c, double position) {
     assert(incoming.count(c->getID()) > 0 && "car is not scheduled to be on this road");
-    if (cars.count(c->getID()) > 0 || flow + 1 > capacity) return false;
+    if (carOnRoad(c) || flow + 1 > capacity) return false;
+    CarStore *store = graph->getCarStore();
+    vector<double> &positions = store->getPositions();
+    int i = flow;
+    while (i > 0 && positions[at(i - 1).index] < position) { // cars usually enter at the source, so this rarely shifts
+        at(i) = at(i - 1);
+        i--;
+    }
+    at(i) = c->getHandle();
     addFlow(1);
-    cars[c->getID()] = c;
+    positions[c->getHandle().index] = position;
+    store->getStopped()[c->getHandle().index] = i < queued;
+    if (i < queued) queued++;
+    if (i == 0) wake(); // the car at the front of the queue changed
     incoming.erase(c->getID());
     c->setRoad(this);
-    c->setSpeed(getRandomSpeed());
+    c->setSpeed(getRandomSpeed(c));
     if (c->hasNextRoad()) c->peekNextRoad()->addIncoming(c);
+    updateActive();
     return true;
 }
 
 /**
- * Removes a car from the road segment.
+ * Removes a car from the road segment. The car must not be waiting in the queue.
  * Returns true if the car was removed, false otherwise (car was not on the road).
  * @param c the pointer to the car
  */
 bool RoadSegment::removeCar(Car *c) {
-    assert(inQueue.count(c->getID()) == 0);
     assert(incoming.count(c->getID()) == 0);
-    if (cars.count(c->getID()) == 0 || flow - 1 < 0) return false;
+    if (!carOnRoad(c) || flow - 1 < 0) return false;
+    assert(!isStopped(c->getHandle()) && "car is waiting in the queue");
+    int i = 0;
+    while (at(i).index != c->getHandle().index) i++;
+    if (i == 0) {
+        front = (front + 1) % capacity;
+    } else {
+        for (; i + 1 < flow; i++) {
+            at(i) = at(i + 1);
+        }
+    }
+    bool wasFull = flow == capacity;
     subtractFlow(1);
-    cars.erase(c->getID());
     c->setRoad(nullptr);
+    updateActive();
+    if (wasFull) { // the queues waiting for room can try again
+        for (RoadSegment *r : blocked) {
+            r->wake();
+        }
+        blocked.clear();
+    }
     return true;
 }
 
@@ -153,19 +224,21 @@ bool RoadSegment::removeCar(Car *c) {
  * @param c the pointer to the car
  */
 bool RoadSegment::carOnRoad(Car *c) {
-    return cars.count(c->getID()) > 0;
+    return c->getCurrentRoad() == this;
 }
 
 /**
  * Stops the car and adds it to the waiting queue. Returns true if the car was added,
  * false otherwise (car is already in the queue).
- * @param id the ID of the car
- */
-bool RoadSegment::stop(int id) {
-    assert(cars.count(id) > 0 && "no car with this id exists");
-    if (inQueue.count(id) > 0) return false;
-    waiting.push(id);
-    inQueue.insert(id);
+ * The cars ahead of a stopping car must be waiting in the queue or leaving the road.
+ * @param h the handle of the car
+ */
+bool RoadSegment::stop(CarHandle h) {
+    CarStore *store = graph->getCarStore();
+    assert(store->getRoads()[h.index] == this && "car is not on this road");
+    if (store->getStopped()[h.index]) return false;
+    store->getStopped()[h.index] = true;
+    queued++;
     return true;
 }
 
@@ -173,20 +246,18 @@ bool RoadSegment::stop(int id) {
  * Returns the next car in the waiting queue.
  */
 Car *RoadSegment::getNextCarFromQueue() {
-    assert(inQueue.size() > 0 && "there are no cars in the waiting queue");
-    Car *next = cars[waiting.front()];
-    return next;
+    assert(queued > 0 && "there are no cars in the waiting queue");
+    return graph->getCarStore()->getCar(at(0));
 }
 
 /**
- * Removes the next car in the waiting queue.
+ * Removes the next car in the waiting queue. The car stays on the road until it is removed.
  * @param currentTime the current time in the simulation
  */
 void RoadSegment::removeNextCarFromQueue(double currentTime) {
-    assert(inQueue.size() > 0 && "there are no cars in the waiting queue");
-    Car *next = cars[waiting.front()];
-    waiting.pop();
-    inQueue.erase(next->getID());
+    assert(queued > 0 && "there are no cars in the waiting queue");
+    graph->getCarStore()->getStopped()[at(0).index] = false;
+    queued--;
     latestTime = currentTime;
 }
 
@@ -194,23 +265,22 @@ void RoadSegment::removeNextCarFromQueue(double currentTime) {
  * Returns the last car in the waiting queue.
  */
 Car *RoadSegment::getLastCarInQueue() {
-    assert(inQueue.size() > 0 && "there are no cars in the waiting queue");
-    Car *last = cars[waiting.back()];
-    return last;
+    assert(queued > 0 && "there are no cars in the waiting queue");
+    return graph->getCarStore()->getCar(at(queued - 1));
 }
 
 /**
  * Returns the number of cars in the waiting queue.
  */
-int RoadSegment::countCarsInQueue() const { return inQueue.size(); };
+int RoadSegment::countCarsInQueue() const { return queued; };
 
 /**
- * Returns true if the car with the specified ID is in the waiting queue, false otherwise.
- * @param id the ID of the car
+ * Returns true if the car is in the waiting queue, false otherwise.
+ * @param h the handle of the car
  */
-bool RoadSegment::isStopped(int id) const {
-    assert(cars.count(id) > 0 && "car is not in road");
-    return inQueue.count(id) > 0;
+bool RoadSegment::isStopped(CarHandle h) const {
+    assert(graph->getCarStore()->getRoads()[h.index] == this && "car is not in road");
+    return graph->getCarStore()->getStopped()[h.index];
 }
 
 /**
@@ -219,6 +289,7 @@ bool RoadSegment::isStopped(int id) const {
 void RoadSegment::addIncoming(Car *c) {
     assert(incoming.count(c->getID()) == 0 && "car is already scheduled to go on this road");
     incoming.insert(c->getID());
+    updateActive();
 }
 
 /**
@@ -227,18 +298,112 @@ void RoadSegment::addIncoming(Car *c) {
 double RoadSegment::getLatestTime() const { return latestTime; }
 
 /**
- * Returns a pointer to a car given its ID.
- * @param id the ID of the car
+ * Returns true if the road segment has cars on it or cars scheduled to be on it, false otherwise.
+ */
+bool RoadSegment::isActive() const { return flow > 0 || !incoming.empty(); }
+
+/**
+ * Returns the index of the road segment in the active roads of its graph, -1 if it is idle.
+ */
+int RoadSegment::getActiveIndex() const { return activeIndex; }
+
+/**
+ * Sets the index of the road segment in the active roads of its graph.
+ * @param index the index in the active roads, -1 if the road segment is idle
+ */
+void RoadSegment::setActiveIndex(int index) { activeIndex = index; }
+
+/**
+ * Returns the local index of the road segment among the inbound road segments of its destination.
+ */
+int RoadSegment::getInSlot() const { return inSlot; }
+
+/**
+ * Sets the local index of the road segment among the inbound road segments of its destination.
+ * @param slot the local index
+ */
+void RoadSegment::setInSlot(int slot) { inSlot = slot; }
+
+/**
+ * Returns the local index of the road segment among the outbound road segments of its source.
+ */
+int RoadSegment::getOutSlot() const { return outSlot; }
+
+/**
+ * Sets the local index of the road segment among the outbound road segments of its source.
+ * @param slot the local index
+ */
+void RoadSegment::setOutSlot(int slot) { outSlot = slot; }
+
+/**
+ * Returns true if the waiting queue is waiting for a light or for room on the next road, false otherwise.
+ * A queue that is asleep does not need to be checked until it is woken.
+ */
+bool RoadSegment::isAsleep() const { return waitingFor != AWAKE; }
+
+/**
+ * Puts the waiting queue to sleep until a light from this road segment turns green.
+ */
+void RoadSegment::waitForLight() {
+    assert(queued > 0 && "there are no cars in the waiting queue");
+    waitingFor = WAITING_FOR_LIGHT;
+}
+
+/**
+ * Puts the waiting queue to sleep until a car leaves the next road segment.
+ * @param next the full road segment the car at the front of the queue is going to
+ */
+void RoadSegment::waitForRoom(RoadSegment *next) {
+    assert(queued > 0 && "there are no cars in the waiting queue");
+    waitingFor = WAITING_FOR_ROOM;
+    waitingRoad = next;
+    next->blocked.push_back(this);
+}
+
+/**
+ * Wakes the waiting queue if it is waiting for a light. Called when a light from this road segment turns green.
+ */
+void RoadSegment::wakeFromLight() {
+    if (waitingFor == WAITING_FOR_LIGHT) wake();
+}
+
+/**
+ * Wakes the waiting queue and adds the road segment to the woken road segments of its graph.
+ */
+void RoadSegment::wake() {
+    if (waitingFor == AWAKE) return;
+    waitingFor = AWAKE;
+    waitingRoad = nullptr;
+    if (graph != nullptr) graph->getWokenRoadSegments().push_back(this);
+}
+
+/**
+ * Adds the road segment to the active roads of its graph when it gets its first car, and removes it when its last
+ * car leaves.
+ */
+void RoadSegment::updateActive() {
+    if (graph == nullptr || isActive() == (activeIndex >= 0)) return;
+    if (isActive()) graph->activate(this);
+    else graph->deactivate(this);
+}
+
+/**
+ * Returns the handle of the car that is i-th closest to the destination.
+ * @param i the index of the car (0 is the car closest to the destination)
  */
-Car *RoadSegment::getCar(int id) {
-    assert(cars.count(id) > 0 && "car is not in road");
-    return cars[id];
+CarHandle RoadSegment::getCarAt(int i) const {
+    assert(i >= 0 && i < flow && "the index must statisfy 0 <= index < flow");
+    return cars[(front + i) % capacity];
 }
 
 /**
- * Returns an immutable reference to the cars (and their IDs) on this road segment.
+ * Returns the point in the cartesian plane at a distance along the road segment from its source.
+ * @param position the distance from the source
  */
-const unordered_map<int, Car*> &RoadSegment::getCars() const { return cars; }
+Point2D RoadSegment::getLocationAt(double position) const {
+    Point2D srcLoc = source->getLocation();
+    return Point2D(srcLoc.x + directionX * position, srcLoc.y + directionY * position);
+}
 
 /**
  * Returns the direction of this road as an angle (between -pi and pi).
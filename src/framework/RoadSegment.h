@@ -1,61 +1,93 @@
 #ifndef ROADSEGMENT_H_
 #define ROADSEGMENT_H_
 
-#include <queue>
+#include <vector>
 #include <unordered_set>
-#include <unordered_map>
 #include "Forward.h"
 #include "Intersection.h"
 #include "Car.h"
+#include "CarStore.h"
 
 #define MIN_SPEED 0.001
 #define EPS 1e-9
 
+// what the car at the front of the waiting queue is waiting for
+#define AWAKE 0 // nothing, the queue is checked every iteration
+#define WAITING_FOR_LIGHT 1 // a light from the road segment to turn green
+#define WAITING_FOR_ROOM 2 // a car to leave the next road segment
+
 struct RoadSegment {
 private:
-    static int counter; // number of road segments that have been created
     int id; // each road segment has a unique id number
+    int index; // the dense index of the road segment in the compiled graph
     Intersection *source; // the source intersection
     Intersection *destination; // the destination intersection
     double length; // the length of the road segment
+    double directionX; // the x component of the unit vector from the source to the destination
+    double directionY; // the y component of the unit vector from the source to the destination
     double speedLimit; // the speed limit of the road segment
     int flow; // the current amount of traffic on the road segment
     int capacity; // the maximum number of vehicles on the road segment
-    std::unordered_map<int, Car*> cars; // the cars on this road segement
-    std::queue<int> waiting; // the queue of cars waiting on this intersection
+    WeightedDigraph *graph; // the graph the road segment is in
+    std::vector<CarHandle> cars; // ring buffer of the cars on this road segment, ordered from the destination to the source
+    int front; // the index in the ring buffer of the car closest to the destination
+    int queued; // the number of cars waiting in the queue, which are always the cars closest to the destination
     double latestTime; // the latest time a car left the waiting queue
-    std::unordered_set<int> inQueue; // the IDs of the cars in the queue
     std::unordered_set<int> incoming; // the IDs of the next cars scheduled to be on this road
+    int activeIndex; // the index of the road segment in the active roads of its graph, -1 if it is idle
+    int inSlot; // the local index of the road segment among the inbound road segments of its destination
+    int outSlot; // the local index of the road segment among the outbound road segments of its source
+    int waitingFor; // what the car at the front of the waiting queue is waiting for
+    RoadSegment *waitingRoad; // the full road segment the queue is waiting on
+    std::vector<RoadSegment*> blocked; // the road segments whose queues are waiting for a car to leave this road segment
 
     void addFlow(int value);
     void subtractFlow(int value);
+    CarHandle &at(int i);
+    void updateActive();
 
 public:
     RoadSegment(Intersection *source, Intersection *destination, double speedLimit, int capacity);
     ~RoadSegment();
     int getID() const;
+    int getIndex() const;
+    void setIndex(int index);
     Intersection *getSource() const;
     Intersection *getDestination() const;
+    WeightedDigraph *getGraph() const;
+    void setGraph(WeightedDigraph *G);
     double getLength() const;
     double getSpeedLimit() const;
     double getExpectedTime() const;
     int getFlow() const;
     int getCapacity() const;
     double getProjectedSpeed() const;
-    double getRandomSpeed() const;
-    bool addCar(Car *c);
+    double getRandomSpeed(const Car *c) const;
+    bool addCar(Car *c, double position = 0.0);
     bool removeCar(Car *c);
     bool carOnRoad(Car *c);
-    bool stop(int id);
+    bool stop(CarHandle h);
     Car *getNextCarFromQueue();
     void removeNextCarFromQueue(double currentTime);
     Car *getLastCarInQueue();
     int countCarsInQueue() const;
-    bool isStopped(int id) const;
+    bool isStopped(CarHandle h) const;
     void addIncoming(Car *c);
     double getLatestTime() const;
-    Car *getCar(int id);
-    const std::unordered_map<int, Car*> &getCars() const;
+    bool isActive() const;
+    int getActiveIndex() const;
+    void setActiveIndex(int index);
+    int getInSlot() const;
+    void setInSlot(int slot);
+    int getOutSlot() const;
+    void setOutSlot(int slot);
+    bool isAsleep() const;
+    void waitForLight();
+    void waitForRoom(RoadSegment *next);
+    void wakeFromLight();
+    void wake();
+    CarHandle getCarAt(int i) const;
+    Point2D getLocationAt(double position) const;
     double getDirection() const;
     bool operator == (const RoadSegment &r) const;
     bool operator != (const RoadSegment &r) const;
@@ -0,0 +1,63 @@
+#include <assert.h>
+#include "Route.h"
+#include "CSRGraph.h"
+
+using namespace std;
+
+/**
+ * Initializes a route. The road indices are moved into the route, which only takes the memory it needs.
+ * @param C the compiled graph
+ * @param roads the indices of the road segments in the order they are travelled
+ */
+Route::Route(CSRGraph *C, vector<int> &roads) {
+    this->C = C;
+    this->roads.swap(roads);
+    this->roads.shrink_to_fit();
+    hash = hashRoads(this->roads);
+}
+
+/**
+ * Deconstructs the route.
+ */
+Route::~Route() {}
+
+/**
+ * Returns the hash of a sequence of road indices, which is the same as the hash of a route with those roads.
+ * @param roads the indices of the road segments
+ */
+size_t Route::hashRoads(const vector<int> &roads) {
+    size_t h = 14695981039346656037ULL; // FNV-1a over the indices
+    for (int e : roads) {
+        h = (h ^ (unsigned int) e) * 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ * Returns the number of road segments on the route.
+ */
+int Route::size() const { return roads.size(); }
+
+/**
+ * Returns a road segment on the route.
+ * @param i the position of the road segment on the route
+ */
+RoadSegment *Route::getRoad(int i) const {
+    assert(i >= 0 && i < (int) roads.size() && "position is not on the route");
+    return C->getRoadSegment(roads[i]);
+}
+
+/**
+ * Returns the indices of the road segments on the route.
+ */
+const vector<int> &Route::getRoads() const { return roads; }
+
+/**
+ * Returns the hash of the road indices.
+ */
+size_t Route::getHash() const { return hash; }
+
+/**
+ * Returns the number of bytes used by the route.
+ */
+size_t Route::getMemoryUsage() const { return sizeof(Route) + roads.capacity() * sizeof(int); }
@@ -0,0 +1,31 @@
+#ifndef ROUTE_H_
+#define ROUTE_H_
+
+#include <cstddef> // for size_t
+#include <vector>
+#include "Forward.h"
+
+/**
+ * An immutable route through the compiled graph, stored as the indices of its road segments. Routes are interned by
+ * a RouteStore, so cars that take the same roads share one route through a shared pointer instead of each holding a
+ * copy of the path. Routes are indexed by the compiled graph they were built from, so they must not be used once a
+ * road segment is added or removed.
+ */
+struct Route {
+private:
+    CSRGraph *C; // the compiled graph the route was built from
+    std::vector<int> roads; // the indices of the road segments in the order they are travelled
+    size_t hash; // the hash of the road indices
+
+public:
+    Route(CSRGraph *C, std::vector<int> &roads);
+    ~Route();
+    static size_t hashRoads(const std::vector<int> &roads);
+    int size() const;
+    RoadSegment *getRoad(int i) const;
+    const std::vector<int> &getRoads() const;
+    size_t getHash() const;
+    size_t getMemoryUsage() const;
+};
+
+#endif
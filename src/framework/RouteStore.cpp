@@ -0,0 +1,87 @@
+#include <algorithm>
+#include "RouteStore.h"
+#include "RoadSegment.h"
+
+using namespace std;
+
+/**
+ * Initializes an empty store.
+ * @param C the compiled graph
+ */
+RouteStore::RouteStore(CSRGraph *C) {
+    this->C = C;
+    sweepAt = ROUTE_STORE_MIN_SWEEP;
+    hits = misses = 0;
+}
+
+/**
+ * Deconstructs the store. Routes still held by cars are not deleted until the cars release them.
+ */
+RouteStore::~RouteStore() {}
+
+/**
+ * Returns the route that takes a path, adding it to the store if no car follows the same path.
+ * @param path the road segments in the order they are travelled, which are indexed by the compiled graph
+ */
+shared_ptr<const Route> RouteStore::intern(const vector<RoadSegment*> &path) {
+    vector<int> roads;
+    roads.reserve(path.size());
+    for (RoadSegment *r : path) {
+        roads.push_back(r->getIndex());
+    }
+    size_t hash = Route::hashRoads(roads);
+    lock_guard<mutex> guard(lock);
+    auto range = routes.equal_range(hash);
+    for (auto it = range.first; it != range.second; it++) {
+        shared_ptr<const Route> route = it->second.lock();
+        if (route != nullptr && route->getRoads() == roads) {
+            hits++;
+            return route;
+        }
+    }
+    misses++;
+    shared_ptr<const Route> route(new Route(C, roads)); // not make_shared, which would keep the route allocated until its entry is swept
+    routes.emplace(hash, route);
+    if (routes.size() >= sweepAt) sweep();
+    return route;
+}
+
+/**
+ * Removes the entries of routes that no car uses any more. The next sweep happens once the store has doubled.
+ * The lock must be held.
+ */
+void RouteStore::sweep() {
+    for (auto it = routes.begin(); it != routes.end();) {
+        if (it->second.expired()) it = routes.erase(it);
+        else it++;
+    }
+    sweepAt = max((size_t) ROUTE_STORE_MIN_SWEEP, 2 * routes.size());
+}
+
+/**
+ * Returns the number of routes in the store that are still used by a car.
+ */
+int RouteStore::countRoutes() {
+    lock_guard<mutex> guard(lock);
+    int count = 0;
+    for (auto &it : routes) {
+        if (!it.second.expired()) count++;
+    }
+    return count;
+}
+
+/**
+ * Returns the number of routes that were shared with an earlier car.
+ */
+int RouteStore::countHits() {
+    lock_guard<mutex> guard(lock);
+    return hits;
+}
+
+/**
+ * Returns the number of distinct routes added to the store.
+ */
+int RouteStore::countMisses() {
+    lock_guard<mutex> guard(lock);
+    return misses;
+}
@@ -0,0 +1,40 @@
+#ifndef ROUTESTORE_H_
+#define ROUTESTORE_H_
+
+#include <cstddef> // for size_t
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Forward.h"
+#include "Route.h"
+
+#define ROUTE_STORE_MIN_SWEEP 1024 // the fewest routes the store holds before it sweeps out routes no car uses
+
+/**
+ * Interns the routes of the compiled graph, so identical paths are stored once and shared by every car that takes
+ * them. The store only holds weak pointers, so a route is deleted when the last car following it releases it, and
+ * the entries of deleted routes are swept out once the store has doubled in size since the last sweep.
+ * Routes can be interned from several threads at once.
+ */
+struct RouteStore {
+private:
+    CSRGraph *C; // the compiled graph
+    std::unordered_multimap<size_t, std::weak_ptr<const Route>> routes; // maps the hash of a route to the route
+    size_t sweepAt; // the number of entries at which the next sweep happens
+    int hits; // the number of routes found in the store
+    int misses; // the number of routes added to the store
+    std::mutex lock; // guards the fields above
+
+    void sweep();
+
+public:
+    RouteStore(CSRGraph *C);
+    ~RouteStore();
+    std::shared_ptr<const Route> intern(const std::vector<RoadSegment*> &path);
+    int countRoutes();
+    int countHits();
+    int countMisses();
+};
+
+#endif
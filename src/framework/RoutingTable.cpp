@@ -0,0 +1,152 @@
+#include <limits>
+#include <assert.h>
+#include "RoutingTable.h"
+#include "CSRGraph.h"
+#include "RoadSegment.h"
+#include "RoutingWorkspace.h"
+
+using namespace std;
+
+/**
+ * Builds the table of a destination with Dijkstra's algorithm over the inbound road segments, in the workspace of
+ * the calling thread.
+ * @param C the compiled graph
+ * @param destination the index of the destination intersection
+ * @param weight the travel time of each road segment by index
+ */
+RoutingTable::RoutingTable(CSRGraph *C, int destination, const vector<double> &weight) {
+    assert(destination >= 0 && destination < C->countIntersections() && "the index must statisfy 0 <= index < number of intersections");
+    const vector<int> &inStart = C->getInStart(), &inRoads = C->getInRoads(), &source = C->getSources();
+    int n = C->countIntersections();
+    this->destination = C->getIntersection(destination);
+    nextRoad.assign(n, nullptr);
+    timeLeft.assign(n, numeric_limits<double>::infinity());
+    RoutingWorkspace &W = RoutingWorkspace::local();
+    W.reset(n);
+    RadixHeap &pq = W.getHeap();
+    W.setTime(destination, 0.0, -1);
+    pq.push(0.0, destination);
+    while (!pq.empty()) {
+        pair<double, int> top = pq.pop();
+        int v = top.second;
+        if (W.isSettled(v)) continue;
+        W.settle(v);
+        timeLeft[v] = top.first;
+        if (W.getRoad(v) != -1) nextRoad[v] = C->getRoadSegment(W.getRoad(v));
+        for (int i = inStart[v]; i < inStart[v + 1]; i++) {
+            int e = inRoads[i];
+            int w = source[e];
+            if (W.getTime(w) > top.first + weight[e]) {
+                W.setTime(w, top.first + weight[e], e);
+                pq.push(top.first + weight[e], w);
+            }
+        }
+    }
+}
+
+/**
+ * Deconstructs the table.
+ */
+RoutingTable::~RoutingTable() {}
+
+/**
+ * Repairs the tree after the travel times of some road segments changed. Every intersection whose route used a road
+ * segment that got slower loses its route, along with every intersection whose route goes through it. Those
+ * intersections take the best road segment to an intersection that kept its route, and intersections next to a road
+ * segment that got faster take it if it beats their route. The new times are then spread backwards in order of time,
+ * as in Dijkstra's algorithm, so the tree is exact again and only the intersections whose time changed are searched.
+ * @param C the compiled graph
+ * @param weight the travel time of each road segment by index, after the changes
+ * @param changed the indices of the road segments whose travel time changed (each at most once)
+ * @return the number of intersections visited, which measures the work done
+ */
+int RoutingTable::update(CSRGraph *C, const vector<double> &weight, const vector<int> &changed) {
+    const vector<int> &inStart = C->getInStart(), &inRoads = C->getInRoads(), &outStart = C->getOutStart(), &outRoads = C->getOutRoads();
+    const vector<int> &source = C->getSources(), &destination = C->getDestinations();
+    RoutingWorkspace &W = RoutingWorkspace::local();
+    W.reset(C->countIntersections());
+    RadixHeap &pq = W.getHeap();
+    vector<int> lost; // the intersections whose route used a road segment that got slower, marked as targets in W
+    for (int e : changed) {
+        int u = source[e], v = destination[e];
+        if (nextRoad[u] != nullptr && nextRoad[u]->getIndex() == e && timeLeft[u] < weight[e] + timeLeft[v] && !W.isTarget(u)) {
+            W.markTarget(u);
+            lost.push_back(u);
+        }
+    }
+    for (int i = 0; i < (int) lost.size(); i++) { // the intersections whose route goes through one that lost its route
+        int v = lost[i];
+        for (int j = inStart[v]; j < inStart[v + 1]; j++) {
+            int e = inRoads[j];
+            int u = source[e];
+            if (!W.isTarget(u) && nextRoad[u] != nullptr && nextRoad[u]->getIndex() == e) {
+                W.markTarget(u);
+                lost.push_back(u);
+            }
+        }
+    }
+    for (int u : lost) {
+        timeLeft[u] = numeric_limits<double>::infinity();
+        nextRoad[u] = nullptr;
+    }
+    for (int u : lost) {
+        for (int j = outStart[u]; j < outStart[u + 1]; j++) {
+            int e = outRoads[j];
+            if (weight[e] + timeLeft[destination[e]] < timeLeft[u]) {
+                timeLeft[u] = weight[e] + timeLeft[destination[e]];
+                nextRoad[u] = C->getRoadSegment(e);
+            }
+        }
+        if (timeLeft[u] != numeric_limits<double>::infinity()) pq.push(timeLeft[u], u);
+    }
+    for (int e : changed) {
+        int u = source[e], v = destination[e];
+        if (weight[e] + timeLeft[v] < timeLeft[u]) {
+            timeLeft[u] = weight[e] + timeLeft[v];
+            nextRoad[u] = C->getRoadSegment(e);
+            pq.push(timeLeft[u], u);
+        }
+    }
+    int visited = lost.size();
+    while (!pq.empty()) {
+        pair<double, int> top = pq.pop();
+        int v = top.second;
+        if (top.first > timeLeft[v]) continue; // the time to v improved after this entry was pushed
+        visited++;
+        for (int j = inStart[v]; j < inStart[v + 1]; j++) {
+            int e = inRoads[j];
+            int u = source[e];
+            if (top.first + weight[e] < timeLeft[u]) {
+                timeLeft[u] = top.first + weight[e];
+                nextRoad[u] = C->getRoadSegment(e);
+                pq.push(timeLeft[u], u);
+            }
+        }
+    }
+    return visited;
+}
+
+/**
+ * Returns a pointer to the destination intersection.
+ */
+Intersection *RoutingTable::getDestination() const { return destination; }
+
+/**
+ * Returns a pointer to the first road segment of the fastest route from an intersection to the destination,
+ * nullptr if the intersection is the destination or there is no route.
+ * @param v the index of the intersection
+ */
+RoadSegment *RoutingTable::getNextRoad(int v) const { return nextRoad[v]; }
+
+/**
+ * Returns the time at the speed limit from an intersection to the destination, infinity if there is no route.
+ * @param v the index of the intersection
+ */
+double RoutingTable::getTimeLeft(int v) const { return timeLeft[v]; }
+
+/**
+ * Returns the number of bytes used by the table.
+ */
+size_t RoutingTable::getMemoryUsage() const {
+    return sizeof(RoutingTable) + nextRoad.capacity() * sizeof(RoadSegment*) + timeLeft.capacity() * sizeof(double);
+}
@@ -0,0 +1,31 @@
+#ifndef ROUTINGTABLE_H_
+#define ROUTINGTABLE_H_
+
+#include <cstddef> // for size_t
+#include <vector>
+#include "Forward.h"
+
+/**
+ * The reverse shortest path tree of one destination intersection, weighted by the travel times of the road segments.
+ * For every intersection it stores the first road segment of the fastest route to the destination and the time left,
+ * so a car only needs to know its destination to find its next road. When travel times change, the tree is repaired
+ * in place where the changes reach instead of being built again. Tables are indexed by the intersection indices of
+ * the compiled graph they were built from.
+ */
+struct RoutingTable {
+private:
+    Intersection *destination; // the destination intersection
+    std::vector<RoadSegment*> nextRoad; // the next road from each intersection, nullptr at the destination or if there is no route
+    std::vector<double> timeLeft; // the time from each intersection to the destination, infinity if there is no route
+
+public:
+    RoutingTable(CSRGraph *C, int destination, const std::vector<double> &weight);
+    ~RoutingTable();
+    int update(CSRGraph *C, const std::vector<double> &weight, const std::vector<int> &changed);
+    Intersection *getDestination() const;
+    RoadSegment *getNextRoad(int v) const;
+    double getTimeLeft(int v) const;
+    size_t getMemoryUsage() const;
+};
+
+#endif
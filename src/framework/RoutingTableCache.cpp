@@ -0,0 +1,132 @@
+#include <algorithm>
+#include "RoutingTableCache.h"
+#include "CSRGraph.h"
+#include "TravelTimes.h"
+
+using namespace std;
+
+/**
+ * Initializes an empty cache.
+ * @param C the compiled graph
+ * @param times the travel times the tables are built from
+ * @param budget the most bytes the cached tables may use (the last table asked for is kept even if it is larger)
+ */
+RoutingTableCache::RoutingTableCache(CSRGraph *C, TravelTimes *times, size_t budget) {
+    this->C = C;
+    this->times = times;
+    this->budget = budget;
+    used = 0;
+    hits = misses = 0;
+}
+
+/**
+ * Deconstructs the cache. Tables still held by cars are not deleted until the cars release them.
+ */
+RoutingTableCache::~RoutingTableCache() {}
+
+/**
+ * Returns the routing table of a destination, building it if it is not cached. The table is built without holding
+ * the lock, so threads asking for other destinations are not held up.
+ * @param destination the index of the destination intersection
+ */
+shared_ptr<const RoutingTable> RoutingTableCache::get(int destination) {
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = tables.find(destination);
+        if (it != tables.end()) {
+            recent.splice(recent.begin(), recent, it->second.place);
+            hits++;
+            return it->second.table;
+        }
+    }
+    long long synced = times->getLogEnd();
+    shared_ptr<RoutingTable> table = make_shared<RoutingTable>(C, destination, times->getWeights());
+    lock_guard<mutex> guard(lock);
+    auto it = tables.find(destination);
+    if (it != tables.end()) { // another thread built the same table first
+        recent.splice(recent.begin(), recent, it->second.place);
+        hits++;
+        return it->second.table;
+    }
+    misses++;
+    recent.push_front(destination);
+    tables[destination] = {table, recent.begin(), synced};
+    used += table->getMemoryUsage();
+    while (used > budget && recent.size() > 1) {
+        auto last = tables.find(recent.back());
+        used -= last->second.table->getMemoryUsage();
+        tables.erase(last);
+        recent.pop_back();
+    }
+    return table;
+}
+
+/**
+ * Brings the cached tables up to date with the travel times published since they were built or last refreshed,
+ * the ones furthest behind first, until the work done exceeds the budget. A table is repaired where the changes
+ * reach, or built again if more than a quarter of the road segments changed. The tables are changed in place, so the
+ * cars holding them take the new routes at their next intersection. Tables that were dropped from the cache are not
+ * refreshed. Changes every cached table has caught up with are discarded.
+ * @param budget the most intersections to visit (the table being refreshed when it runs out is finished)
+ * @return the number of intersections visited
+ */
+int RoutingTableCache::refresh(int budget) {
+    lock_guard<mutex> guard(lock);
+    long long end = times->getLogEnd();
+    vector<pair<long long, int>> stale; // the sequence number each table is synced to, and its destination
+    for (auto &it : tables) {
+        if (it.second.synced < end) stale.push_back(make_pair(it.second.synced, it.first));
+    }
+    sort(stale.begin(), stale.end());
+    int work = 0;
+    vector<int> changed;
+    for (int i = 0; i < (int) stale.size() && work < budget; i++) {
+        Entry &entry = tables[stale[i].second];
+        times->getChangesSince(entry.synced, changed);
+        if ((int) changed.size() > C->countRoadSegments() / 4) {
+            *entry.table = RoutingTable(C, stale[i].second, times->getWeights());
+            work += C->countIntersections();
+        } else {
+            work += entry.table->update(C, times->getWeights(), changed);
+        }
+        entry.synced = end;
+    }
+    long long oldest = end;
+    for (auto &it : tables) {
+        oldest = min(oldest, it.second.synced);
+    }
+    times->discard(oldest);
+    return work;
+}
+
+/**
+ * Returns the number of cached tables.
+ */
+int RoutingTableCache::countTables() {
+    lock_guard<mutex> guard(lock);
+    return tables.size();
+}
+
+/**
+ * Returns the number of bytes used by the cached tables.
+ */
+size_t RoutingTableCache::getMemoryUsage() {
+    lock_guard<mutex> guard(lock);
+    return used;
+}
+
+/**
+ * Returns the number of times a table was found in the cache.
+ */
+int RoutingTableCache::countHits() {
+    lock_guard<mutex> guard(lock);
+    return hits;
+}
+
+/**
+ * Returns the number of tables built.
+ */
+int RoutingTableCache::countMisses() {
+    lock_guard<mutex> guard(lock);
+    return misses;
+}
@@ -0,0 +1,54 @@
+#ifndef ROUTINGTABLECACHE_H_
+#define ROUTINGTABLECACHE_H_
+
+#include <cstddef> // for size_t
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Forward.h"
+#include "RoutingTable.h"
+
+#define ROUTING_TABLE_BUDGET (64 << 20) // the most bytes the cached routing tables may use
+
+/**
+ * The routing tables of the destinations that cars were sent to, built when a destination is first asked for.
+ * When the tables use more memory than the budget, the least recently used ones are dropped. Cars hold their table
+ * through a shared pointer, so a table that is dropped lives on until the last car using it finishes.
+ * Tables are built from the published travel times, and refresh() brings the cached tables up to date in place when
+ * the travel times change. Tables can be asked for from several threads at once, but not while they are refreshed.
+ */
+struct RoutingTableCache {
+private:
+    /**
+     * A cached table.
+     */
+    struct Entry {
+        std::shared_ptr<RoutingTable> table; // the table
+        std::list<int>::iterator place; // the place of the destination in recent
+        long long synced; // the sequence number of the first travel time change the table has not caught up with
+    };
+
+    CSRGraph *C; // the compiled graph
+    TravelTimes *times; // the travel times the tables are built from
+    size_t budget; // the most bytes the cached tables may use
+    size_t used; // the bytes used by the cached tables
+    std::list<int> recent; // the destinations of the cached tables, most recently used first
+    std::unordered_map<int, Entry> tables; // maps a destination to its cached table
+    int hits; // the number of tables found in the cache
+    int misses; // the number of tables built
+    std::mutex lock; // guards the fields above
+
+public:
+    RoutingTableCache(CSRGraph *C, TravelTimes *times, size_t budget);
+    ~RoutingTableCache();
+    std::shared_ptr<const RoutingTable> get(int destination);
+    int refresh(int budget);
+    int countTables();
+    size_t getMemoryUsage();
+    int countHits();
+    int countMisses();
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <limits>
+#include <assert.h>
+#include "RoutingWorkspace.h"
+
+using namespace std;
+
+/**
+ * Initializes an empty workspace.
+ */
+RoutingWorkspace::RoutingWorkspace() {
+    epoch = 0;
+}
+
+/**
+ * Deconstructs the workspace.
+ */
+RoutingWorkspace::~RoutingWorkspace() {}
+
+/**
+ * Starts a new search. The arrays only grow, and they are only cleared when the epoch wraps around.
+ * @param intersections the number of intersections in the graph
+ */
+void RoutingWorkspace::reset(int intersections) {
+    if ((int) timeTo.size() < intersections) {
+        timeTo.resize(intersections);
+        roadTo.resize(intersections);
+        reached.resize(intersections, 0);
+        settled.resize(intersections, 0);
+        target.resize(intersections, 0);
+        estimate.resize(intersections);
+        estimated.resize(intersections, 0);
+    }
+    if (++epoch == 0) { // the stamps of old searches could be mistaken for the new one
+        fill(reached.begin(), reached.end(), 0);
+        fill(settled.begin(), settled.end(), 0);
+        fill(target.begin(), target.end(), 0);
+        fill(estimated.begin(), estimated.end(), 0);
+        epoch = 1;
+    }
+    heap.clear();
+}
+
+/**
+ * Returns the best time found to an intersection in the current search, infinity if it has not been reached.
+ * @param v the index of the intersection
+ */
+double RoutingWorkspace::getTime(int v) const { return reached[v] == epoch ? timeTo[v] : numeric_limits<double>::infinity(); }
+
+/**
+ * Returns the index of the last road on the best path to an intersection, -1 if there is none.
+ * @param v the index of the intersection
+ */
+int RoutingWorkspace::getRoad(int v) const { return reached[v] == epoch ? roadTo[v] : -1; }
+
+/**
+ * Sets the best time to an intersection and the last road on the path.
+ * @param v the index of the intersection
+ * @param time the time
+ * @param road the index of the last road, -1 for a source
+ */
+void RoutingWorkspace::setTime(int v, double time, int road) {
+    timeTo[v] = time;
+    roadTo[v] = road;
+    reached[v] = epoch;
+}
+
+/**
+ * Returns true if the time to an intersection is final in the current search, false otherwise.
+ * @param v the index of the intersection
+ */
+bool RoutingWorkspace::isSettled(int v) const { return settled[v] == epoch; }
+
+/**
+ * Marks the time to an intersection as final.
+ * @param v the index of the intersection
+ */
+void RoutingWorkspace::settle(int v) { settled[v] = epoch; }
+
+/**
+ * Returns true if the intersection is one of the destinations of the current search, false otherwise.
+ * @param v the index of the intersection
+ */
+bool RoutingWorkspace::isTarget(int v) const { return target[v] == epoch; }
+
+/**
+ * Marks an intersection as one of the destinations of the current search.
+ * @param v the index of the intersection
+ */
+void RoutingWorkspace::markTarget(int v) { target[v] = epoch; }
+
+/**
+ * Returns true if the estimate of an intersection was set in the current search, false otherwise.
+ * @param v the index of the intersection
+ */
+bool RoutingWorkspace::hasEstimate(int v) const { return estimated[v] == epoch; }
+
+/**
+ * Returns the lower bound on the remaining time from an intersection set in the current search.
+ * @param v the index of the intersection
+ */
+double RoutingWorkspace::getEstimate(int v) const { return estimate[v]; }
+
+/**
+ * Sets the lower bound on the remaining time from an intersection, so it is only computed once per search.
+ * @param v the index of the intersection
+ * @param estimate the lower bound
+ */
+void RoutingWorkspace::setEstimate(int v, double estimate) {
+    this->estimate[v] = estimate;
+    estimated[v] = epoch;
+}
+
+/**
+ * Returns a reference to the heap of the workspace.
+ */
+RadixHeap &RoutingWorkspace::getHeap() { return heap; }
+
+/**
+ * Returns a reference to one of the workspaces of the calling thread.
+ * @param slot the workspace, 0 <= slot < WORKSPACES
+ */
+RoutingWorkspace &RoutingWorkspace::local(int slot) {
+    assert(slot >= 0 && slot < WORKSPACES && "the slot must statisfy 0 <= slot < WORKSPACES");
+    static thread_local RoutingWorkspace workspaces[WORKSPACES];
+    return workspaces[slot];
+}
@@ -0,0 +1,44 @@
+#ifndef ROUTINGWORKSPACE_H_
+#define ROUTINGWORKSPACE_H_
+
+#include <vector>
+#include "../misc/RadixHeap.h"
+
+#define WORKSPACES 2 // the number of workspaces of each thread, so a bidirectional search can run one in each direction
+
+/**
+ * The scratch arrays of a shortest path search, indexed by intersection index. Each thread has its own workspace,
+ * which is reused by every search on that thread. Entries are stamped with the epoch of the search that wrote them,
+ * so starting a new search is constant time instead of a pass over every intersection.
+ */
+struct RoutingWorkspace {
+private:
+    std::vector<double> timeTo; // the best time found to each intersection
+    std::vector<int> roadTo; // the index of the last road on the best path to each intersection, -1 for none
+    std::vector<unsigned int> reached; // the epoch in which the time to each intersection was last set
+    std::vector<unsigned int> settled; // the epoch in which each intersection was settled
+    std::vector<unsigned int> target; // the epoch in which each intersection was marked as a destination
+    std::vector<double> estimate; // the lower bound on the time from each intersection to the nearest destination
+    std::vector<unsigned int> estimated; // the epoch in which the estimate of each intersection was set
+    unsigned int epoch; // the epoch of the current search
+    RadixHeap heap; // the intersections to visit, keyed by time
+
+public:
+    RoutingWorkspace();
+    ~RoutingWorkspace();
+    void reset(int intersections);
+    double getTime(int v) const;
+    int getRoad(int v) const;
+    void setTime(int v, double time, int road);
+    bool isSettled(int v) const;
+    void settle(int v);
+    bool isTarget(int v) const;
+    void markTarget(int v);
+    bool hasEstimate(int v) const;
+    double getEstimate(int v) const;
+    void setEstimate(int v, double estimate);
+    RadixHeap &getHeap();
+    static RoutingWorkspace &local(int slot = 0);
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <assert.h>
+#include "SignalSchedule.h"
+#include "CSRGraph.h"
+#include "Intersection.h"
+#include "MovementGraph.h"
+#include "RoutingWorkspace.h"
+
+using namespace std;
+
+/**
+ * Builds the schedule from the signal plan of each intersection. The movements are visited in the same order as
+ * when the movement graph was built, so each green interval is filed under the right movement.
+ * @param C the compiled graph
+ * @param M the movement graph of the compiled graph
+ * @param leftTime the duration of a left phase
+ * @param straightTime the duration of a straight phase, including any left phase before it
+ * @param startTime the time of the first cycle of every intersection
+ */
+SignalSchedule::SignalSchedule(CSRGraph *C, MovementGraph *M, double leftTime, double straightTime, double startTime) {
+    assert(leftTime > 0.0 && straightTime > leftTime && "the phases must have positive durations");
+    this->C = C;
+    this->M = M;
+    this->startTime = startTime;
+    int m = M->countMovements();
+    vector<vector<pair<double, double>>> plan;
+    vector<vector<pair<double, double>>> green(m);
+    vector<int> next(M->getStart().begin(), M->getStart().end() - 1);
+    for (Intersection *v : C->getIntersections()) {
+        period.push_back(v->getSignalPlan(leftTime, straightTime, plan));
+        const vector<TrafficLight*> &movements = v->getMovements();
+        for (int k = 0; k < (int) movements.size(); k++) {
+            green[next[movements[k]->getFrom()->getIndex()]++] = plan[k];
+        }
+    }
+    windowStart.assign(m + 1, 0);
+    for (int j = 0; j < m; j++) {
+        windowStart[j + 1] = windowStart[j] + green[j].size();
+        for (pair<double, double> &w : green[j]) {
+            greenFrom.push_back(w.first);
+            greenTo.push_back(w.second);
+        }
+    }
+}
+
+/**
+ * Deconstructs the schedule.
+ */
+SignalSchedule::~SignalSchedule() {}
+
+/**
+ * Returns the period of the signal plan of an intersection, 0 if it never cycles.
+ * @param v the index of the intersection
+ */
+double SignalSchedule::getPeriod(int v) const { return period[v]; }
+
+/**
+ * Returns the time from a car reaching the stop line until its movement is green. Before the first cycle, the
+ * lights are taken to be as at the start of the period.
+ * @param j the index of the movement in the movement graph
+ * @param v the index of the intersection of the movement
+ * @param time the time the car reaches the stop line
+ * @return the wait, infinity if the movement is never green
+ */
+double SignalSchedule::wait(int j, int v, double time) const {
+    int first = windowStart[j], last = windowStart[j + 1];
+    if (first == last) return numeric_limits<double>::infinity();
+    if (period[v] == 0.0) return 0.0; // the intersection never cycles, so its green lights stay green
+    double offset = max(time - startTime, 0.0);
+    double phase = fmod(offset, period[v]);
+    for (int w = first; w < last; w++) { // the intervals are in order of time
+        if (phase < greenFrom[w]) return startTime + offset - time + greenFrom[w] - phase;
+        if (phase < greenTo[w]) return startTime + offset - time;
+    }
+    return startTime + offset - time + period[v] - phase + greenFrom[first];
+}
+
+/**
+ * Finds the earliest arrival from the end of one of the source road segments to a point on one of the destination
+ * road segments, leaving at a given time, with a time-dependent Dijkstra search over the movements in the workspace
+ * of the calling thread. The label of a road segment is the time a car reaches its stop line. Taking a movement
+ * waits for its light to turn green and then travels the road segment it leads to at the speed limit.
+ * A destination road segment is reached through a movement into it, and is not searched any further.
+ * @param sources the indices of the road segments the route can start on
+ * @param initialTime the time from the departure to the end of each source road segment
+ * @param destinations the indices of the road segments the route can finish on
+ * @param excessTime the time from the start of each destination road segment to the destination
+ * @param departureTime the time the car leaves
+ * @param source the position of the chosen source in sources, -1 if there is no route
+ * @param destination the position of the chosen destination in destinations, -1 if there is no route
+ * @param path the vector the road segments between the source and destination road segments are written to
+ * @return the time from the departure to the arrival, infinity if there is no route
+ */
+double SignalSchedule::route(const vector<int> &sources, const vector<double> &initialTime, const vector<int> &destinations, const vector<double> &excessTime, double departureTime, int &source, int &destination, vector<RoadSegment*> &path) const {
+    const vector<int> &start = M->getStart(), &to = M->getTargets(), &at = C->getDestinations();
+    const vector<double> &expectedTime = C->getExpectedTimes();
+    RoutingWorkspace &W = RoutingWorkspace::local();
+    W.reset(C->countRoadSegments());
+    RadixHeap &pq = W.getHeap();
+    for (int e : destinations) {
+        W.markTarget(e);
+    }
+    for (int s = 0; s < (int) sources.size(); s++) {
+        if (initialTime[s] >= W.getTime(sources[s])) continue;
+        W.setTime(sources[s], initialTime[s], -1); // times are kept relative to the departure
+        pq.push(initialTime[s], sources[s]);
+    }
+    double best = numeric_limits<double>::infinity();
+    int last = -1; // the road segment before the best destination
+    destination = -1;
+    while (!pq.empty()) {
+        pair<double, int> top = pq.pop();
+        int e = top.second;
+        if (W.isSettled(e)) continue; // an earlier arrival at e was already settled
+        if (top.first >= best) break; // waits and excess times are non-negative, so no destination left can do better
+        W.settle(e);
+        for (int j = start[e]; j < start[e + 1]; j++) {
+            int f = to[j];
+            double time = top.first + wait(j, at[e], departureTime + top.first);
+            if (time == numeric_limits<double>::infinity()) continue;
+            if (W.isTarget(f)) {
+                for (int d = 0; d < (int) destinations.size(); d++) {
+                    if (destinations[d] == f && time + excessTime[d] < best) {
+                        best = time + excessTime[d];
+                        last = e;
+                        destination = d;
+                    }
+                }
+            } else if (W.getTime(f) > time + expectedTime[f]) {
+                W.setTime(f, time + expectedTime[f], e);
+                pq.push(time + expectedTime[f], f);
+            }
+        }
+    }
+    path.clear();
+    source = -1;
+    if (last == -1) return best;
+    int e = last;
+    for (; W.getRoad(e) != -1; e = W.getRoad(e)) {
+        path.push_back(C->getRoadSegment(e));
+    }
+    reverse(path.begin(), path.end());
+    for (int s = 0; s < (int) sources.size() && source == -1; s++) {
+        if (sources[s] == e) source = s;
+    }
+    return best;
+}
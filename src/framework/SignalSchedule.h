@@ -0,0 +1,35 @@
+#ifndef SIGNALSCHEDULE_H_
+#define SIGNALSCHEDULE_H_
+
+#include <vector>
+#include "Forward.h"
+
+#define LEFT_PHASE_TIME 10.0 // the duration of a left phase under pretimed control, in seconds
+#define STRAIGHT_PHASE_TIME 30.0 // the duration of a straight phase under pretimed control, including any left phase before it
+
+/**
+ * The known future of the traffic lights when every intersection is cycled at fixed intervals from a common start,
+ * as the PretimedController does. Each intersection repeats with a period, and each movement of the movement graph
+ * keeps the intervals of the period in which it is green, so the wait at a movement from any time is found in closed
+ * form. Waiting for a green light never lets a car that arrives later leave earlier, so the travel times are FIFO and
+ * a time-dependent Dijkstra search finds the earliest arrival.
+ */
+struct SignalSchedule {
+private:
+    CSRGraph *C; // the compiled graph
+    MovementGraph *M; // the movement graph whose movements are scheduled
+    double startTime; // the time of the first cycle of every intersection
+    std::vector<double> period; // the period of each intersection, 0 if it never cycles
+    std::vector<int> windowStart; // the green intervals of movement j are windows[windowStart[j]..windowStart[j + 1])
+    std::vector<double> greenFrom; // the start of each green interval, as a time since the start of the period
+    std::vector<double> greenTo; // the end of each green interval, as a time since the start of the period
+
+public:
+    SignalSchedule(CSRGraph *C, MovementGraph *M, double leftTime, double straightTime, double startTime);
+    ~SignalSchedule();
+    double getPeriod(int v) const;
+    double wait(int j, int v, double time) const;
+    double route(const std::vector<int> &sources, const std::vector<double> &initialTime, const std::vector<int> &destinations, const std::vector<double> &excessTime, double departureTime, int &source, int &destination, std::vector<RoadSegment*> &path) const;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "SimulationContext.h"
+#include "WeightedDigraph.h"
+
+/**
+ * Initializes a context with an empty network, where no IDs have been given out and no car has finished.
+ */
+SimulationContext::SimulationContext() {
+    intersections = 0;
+    roadSegments = 0;
+    trafficLights = 0;
+    cars = 0;
+    efficiency = 1.0;
+    reached = 0;
+    G = new WeightedDigraph(this);
+}
+
+/**
+ * Deconstructs the context and its network.
+ */
+SimulationContext::~SimulationContext() {
+    delete G;
+}
+
+/**
+ * Returns the network of the run.
+ */
+WeightedDigraph *SimulationContext::getGraph() const { return G; }
+
+/**
+ * Returns the ID of a new intersection.
+ */
+int SimulationContext::nextIntersectionID() { return intersections++; }
+
+/**
+ * Returns the ID of a new road segment.
+ */
+int SimulationContext::nextRoadSegmentID() { return roadSegments++; }
+
+/**
+ * Returns the ID of a new traffic light.
+ */
+int SimulationContext::nextTrafficLightID() { return trafficLights++; }
+
+/**
+ * Returns the ID of a new car.
+ */
+int SimulationContext::nextCarID() { return cars++; }
+
+/**
+ * Adds the efficiency of a car that reached its destination to the average.
+ * @param efficiency the expected time of the car's trip divided by the time it took
+ */
+void SimulationContext::recordArrival(double efficiency) {
+    this->efficiency = ((this->efficiency * reached) + efficiency) / (reached + 1);
+    reached++;
+}
+
+/**
+ * Returns the average efficiency of the cars that reached their destination, 1 if none have.
+ */
+double SimulationContext::getEfficiency() const { return efficiency; }
+
+/**
+ * Returns the number of cars that reached their destination.
+ */
+int SimulationContext::getReached() const { return reached; }
@@ -0,0 +1,35 @@
+#ifndef SIMULATIONCONTEXT_H_
+#define SIMULATIONCONTEXT_H_
+
+#include "Forward.h"
+
+/**
+ * The state of one run of the simulation: the network, the IDs given out to the objects created in it, and the
+ * efficiency of the cars that finished their trips in it. Every intersection, road segment, traffic light and car
+ * belongs to one context, so independent runs can share a process, and each one can be driven on its own thread.
+ * A context is not meant to be used from several threads at once.
+ */
+struct SimulationContext {
+private:
+    WeightedDigraph *G; // the network of the run
+    int intersections; // the number of intersections that have been created, which is the next intersection ID
+    int roadSegments; // the number of road segments that have been created, which is the next road segment ID
+    int trafficLights; // the number of traffic lights that have been created, which is the next traffic light ID
+    int cars; // the number of cars that have been created, which is the next car ID
+    double efficiency; // the average efficiency of the cars that reached their destination
+    int reached; // the number of cars that reached their destination
+
+public:
+    SimulationContext();
+    ~SimulationContext();
+    WeightedDigraph *getGraph() const;
+    int nextIntersectionID();
+    int nextRoadSegmentID();
+    int nextTrafficLightID();
+    int nextCarID();
+    void recordArrival(double efficiency);
+    double getEfficiency() const;
+    int getReached() const;
+};
+
+#endif
@@ -1,7 +1,7 @@
 #include <assert.h>
 #include "TrafficLight.h"
-
-int TrafficLight::counter = 0; // counter starts at 0
+#include "Intersection.h"
+#include "SimulationContext.h"
 
 /**
  * Initializes a traffic light with a default state of RED.
@@ -10,7 +10,7 @@ int TrafficLight::counter = 0; // counter starts at 0
  * @param type the type of turn this traffic light controls
  */
 TrafficLight::TrafficLight(RoadSegment *from, RoadSegment *to, int type) {
-    this->id = counter++; // assigns an id and increments the counter
+    this->id = from->getDestination()->getContext()->nextTrafficLightID(); // assigns an id from the context of the intersection
     assert(type >= 0 && type <= 3 && "Traffic Light is not a valid type");
     this->state = type == RIGHT ? GREEN : RED; // default state (green if it is a right turn, red otherwise)
     this->from = from;
@@ -45,11 +45,12 @@ int TrafficLight::getID() const { return id; }
 int TrafficLight::getState() const { return state; }
 
 /**
- * Changes the current state of the traffic light.
+ * Changes the current state of the traffic light. A light turning green wakes the queue waiting on its road.
  * @param state the new state of the traffic light (0 for red, 1 for green, 2 for yellow)
  */
 void TrafficLight::setState(int state) {
     this->state = state;
+    if (state == GREEN) from->wakeFromLight(); // the queue on the road may be waiting for this light
 }
 
 /**
@@ -17,7 +17,6 @@
 
 struct TrafficLight {
 private:
-    static int counter; // number of traffic lights that have been created
     int id; // each traffic light has a unique id number
     int state; // current state of the traffic light
     int type; // the type of turning this traffic light controls
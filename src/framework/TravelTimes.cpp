@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cmath>
+#include <assert.h>
+#include "TravelTimes.h"
+#include "CSRGraph.h"
+#include "CarStore.h"
+#include "RoadSegment.h"
+#include "WeightedDigraph.h"
+
+using namespace std;
+
+/**
+ * Initializes the travel times of every road segment to the time to travel it at the speed limit.
+ * @param C the compiled graph
+ */
+TravelTimes::TravelTimes(CSRGraph *C) {
+    this->C = C;
+    freeFlow = C->getExpectedTimes();
+    average = freeFlow;
+    weight = freeFlow;
+    updated.assign(freeFlow.size(), 0.0);
+    pending.assign(freeFlow.size(), false);
+    logStart = 0;
+}
+
+/**
+ * Deconstructs the travel times.
+ */
+TravelTimes::~TravelTimes() {}
+
+/**
+ * Adds the time a car took to travel a road segment to its moving average. Cars may reach the end of a road a little
+ * early within a time step, so times below free flow are raised to it.
+ * @param e the index of the road segment
+ * @param time the time the car took to travel the road segment
+ * @param currentTime the current time in the simulation
+ */
+void TravelTimes::observe(int e, double time, double currentTime) {
+    assert(e >= 0 && e < (int) average.size() && "the index must statisfy 0 <= index < number of road segments");
+    average[e] += TRAVEL_TIME_SMOOTHING * (max(time, freeFlow[e]) - average[e]);
+    updated[e] = currentTime;
+    if (!pending[e]) {
+        pending[e] = true;
+        candidates.push_back(e);
+    }
+}
+
+/**
+ * Publishes the travel times that changed by more than TRAVEL_TIME_THRESHOLD since they were last published.
+ * Only the road segments observed since the last publication, the ones with cars on them and the ones still slower
+ * than free flow are checked.
+ * @param G the Weighted Directed Graph
+ * @param currentTime the current time in the simulation
+ */
+void TravelTimes::publish(WeightedDigraph *G, double currentTime) {
+    for (RoadSegment *r : G->getActiveRoadSegments()) {
+        if (!pending[r->getIndex()]) {
+            pending[r->getIndex()] = true;
+            candidates.push_back(r->getIndex());
+        }
+    }
+    int kept = 0;
+    for (int e : candidates) {
+        check(e, G->getCarStore(), currentTime);
+        if (average[e] != freeFlow[e] || weight[e] != freeFlow[e]) candidates[kept++] = e;
+        else pending[e] = false;
+    }
+    candidates.resize(kept);
+}
+
+/**
+ * Publishes the travel time of a road segment if it changed enough. The average of an empty road segment decays
+ * towards free flow, and the time the front car has spent on the road segment is a lower bound on its travel time.
+ * Times within TRAVEL_TIME_THRESHOLD of free flow are taken to be free flow.
+ * @param e the index of the road segment
+ * @param store the cars travelling in the graph
+ * @param currentTime the current time in the simulation
+ */
+void TravelTimes::check(int e, CarStore *store, double currentTime) {
+    RoadSegment *r = C->getRoadSegment(e);
+    if (r->getFlow() == 0 && average[e] > freeFlow[e]) {
+        average[e] = freeFlow[e] + (average[e] - freeFlow[e]) * exp((updated[e] - currentTime) / TRAVEL_TIME_DECAY);
+        updated[e] = currentTime;
+        if (average[e] < freeFlow[e] * (1 + TRAVEL_TIME_THRESHOLD)) average[e] = freeFlow[e];
+    }
+    double time = average[e];
+    if (r->getFlow() > 0) {
+        double entered = store->getEntryTimes()[r->getCarAt(0).index];
+        if (entered >= 0.0) time = max(time, currentTime - entered);
+    }
+    if (time < freeFlow[e] * (1 + TRAVEL_TIME_THRESHOLD)) time = freeFlow[e];
+    if (fabs(time - weight[e]) > TRAVEL_TIME_THRESHOLD * weight[e] || (time == freeFlow[e] && weight[e] != freeFlow[e])) {
+        weight[e] = time;
+        changes.push_back(e);
+    }
+}
+
+/**
+ * Returns a reference to the published travel times of the road segments, indexed by road segment.
+ */
+const vector<double> &TravelTimes::getWeights() const { return weight; }
+
+/**
+ * Returns the sequence number the next published change will get.
+ */
+long long TravelTimes::getLogEnd() const { return logStart + changes.size(); }
+
+/**
+ * Collects the road segments whose travel time was published at or after a sequence number, each once.
+ * @param sequence the sequence number, which must not have been discarded
+ * @param out the vector the indices of the road segments are written to
+ */
+void TravelTimes::getChangesSince(long long sequence, vector<int> &out) const {
+    assert(sequence >= logStart && "the changes were discarded");
+    out.assign(changes.begin() + (sequence - logStart), changes.end());
+    sort(out.begin(), out.end());
+    out.erase(unique(out.begin(), out.end()), out.end());
+}
+
+/**
+ * Discards the logged changes before a sequence number, once every routing table has caught up with them.
+ * @param sequence the sequence number
+ */
+void TravelTimes::discard(long long sequence) {
+    if (sequence <= logStart) return;
+    changes.erase(changes.begin(), changes.begin() + (sequence - logStart));
+    logStart = sequence;
+}
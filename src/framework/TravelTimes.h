@@ -0,0 +1,43 @@
+#ifndef TRAVELTIMES_H_
+#define TRAVELTIMES_H_
+
+#include <vector>
+#include "Forward.h"
+
+#define TRAVEL_TIME_SMOOTHING 0.3 // the weight of a new observation in the moving average of a road segment's travel time
+#define TRAVEL_TIME_THRESHOLD 0.2 // the relative change in a road segment's travel time that is passed on to the routes
+#define TRAVEL_TIME_DECAY 60.0 // the seconds for the excess travel time of an empty road segment to fall by a factor of e
+
+/**
+ * The live travel times of the road segments, learned from the cars that travel them. Each road segment keeps an
+ * exponentially weighted moving average of the times cars took to travel it, and a car that has been on a road
+ * segment for longer than the average raises it while it waits. The weights that routes are based on are only
+ * published when they move by more than TRAVEL_TIME_THRESHOLD, and every published change is logged, so routing
+ * tables can catch up on only the road segments that changed since they were last brought up to date.
+ */
+struct TravelTimes {
+private:
+    CSRGraph *C; // the compiled graph
+    std::vector<double> freeFlow; // the time to travel each road segment at the speed limit
+    std::vector<double> average; // the moving average of the observed travel time of each road segment
+    std::vector<double> updated; // the time the average of each road segment last changed
+    std::vector<double> weight; // the published travel time of each road segment
+    std::vector<char> pending; // whether each road segment is in the candidates
+    std::vector<int> candidates; // the road segments observed since the last publication, or still slower than free flow
+    std::vector<int> changes; // the road segments whose weight changed, in the order they were published
+    long long logStart; // the sequence number of the first logged change
+
+    void check(int e, CarStore *store, double currentTime);
+
+public:
+    TravelTimes(CSRGraph *C);
+    ~TravelTimes();
+    void observe(int e, double time, double currentTime);
+    void publish(WeightedDigraph *G, double currentTime);
+    const std::vector<double> &getWeights() const;
+    long long getLogEnd() const;
+    void getChangesSince(long long sequence, std::vector<int> &out) const;
+    void discard(long long sequence);
+};
+
+#endif
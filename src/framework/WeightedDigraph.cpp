@@ -1,21 +1,58 @@
 #include <assert.h>
+#include <algorithm>
 #include <cstdio>
 #include "WeightedDigraph.h"
+#include "SimulationContext.h"
 
 using namespace std;
 
 /**
  * Initializes a Weighted Directed Graph.
+ * @param context the context that owns the graph
  */
-WeightedDigraph::WeightedDigraph() {
+WeightedDigraph::WeightedDigraph(SimulationContext *context) {
+    this->context = context;
     intersections = 0;
     roadSegments = 0;
+    carStore = new CarStore();
+    compiled = nullptr;
+    landmarks = nullptr;
+    hierarchy = nullptr;
+    routingTables = nullptr;
+    travelTimes = nullptr;
+    movementGraph = nullptr;
+    signalSchedule = nullptr;
+    routes = nullptr;
+    turnPenalty = {TURN_PENALTY_LEFT, TURN_PENALTY_STRAIGHT, TURN_PENALTY_RIGHT, TURN_PENALTY_UTURN};
+    routingMode = ROUTING_DIJKSTRA;
+    pool = nullptr;
+    components = 0;
+    componentsChanged = false;
+    reachableWords = 0;
+    reachableChanged = true;
+    setSeed(0);
 }
 
 /**
- * Deconstructs the Weighted Directed Graph.
+ * Deconstructs the Weighted Directed Graph, the cars travelling in it, and its road segments and intersections.
  */
-WeightedDigraph::~WeightedDigraph() {}
+WeightedDigraph::~WeightedDigraph() {
+    delete carStore;
+    for (pair<const int, RoadSegment*> &r : idToRoadSegment) {
+        delete r.second;
+    }
+    for (pair<const int, Intersection*> &n : idToIntersection) {
+        delete n.second; // deletes the traffic lights of the intersection
+    }
+    delete compiled;
+    delete landmarks;
+    delete hierarchy;
+    delete routingTables;
+    delete travelTimes;
+    delete movementGraph;
+    delete signalSchedule;
+    delete routes;
+}
 
 /**
  * Returns the number of intersections (vertices) in this graph.
@@ -35,14 +72,42 @@ int WeightedDigraph::countRoadSegments() const { return roadSegments; }
 bool WeightedDigraph::addRoadSegment(RoadSegment *r) {
     if (idToRoadSegment.count(r->getID())) return false;
     idToRoadSegment[r->getID()] = r;
-    if (idToIntersection.count(r->getSource()->getID()) == 0) intersections++;
+    bool newSource = idToIntersection.count(r->getSource()->getID()) == 0;
+    if (newSource) {
+        intersections++;
+        r->getSource()->setComponent(components++); // a new intersection is a component of its own
+    }
     idToIntersection[r->getSource()->getID()] = r->getSource();
-    if (idToIntersection.count(r->getDestination()->getID()) == 0) intersections++;
+    bool newDestination = idToIntersection.count(r->getDestination()->getID()) == 0;
+    if (newDestination) {
+        intersections++;
+        r->getDestination()->setComponent(components++);
+    }
     idToIntersection[r->getDestination()->getID()] = r->getDestination();
+    // a road segment between two components merges them only if it closes a cycle, which needs a road back to its source
+    if (!newSource && !newDestination && r->getSource()->getComponent() != r->getDestination()->getComponent()) componentsChanged = true;
+    reachableChanged = true; // any road segment may connect components one way
     r->getSource()->add(r);
     r->getDestination()->add(r);
+    r->setGraph(this);
     compressedIndex[r->getID()] = roadSegments++;
     roadSegmentIDs.push_back(r->getID());
+    delete compiled;
+    compiled = nullptr;
+    delete landmarks;
+    landmarks = nullptr;
+    delete hierarchy;
+    hierarchy = nullptr;
+    delete routingTables;
+    routingTables = nullptr;
+    delete travelTimes;
+    travelTimes = nullptr;
+    delete movementGraph;
+    movementGraph = nullptr;
+    delete signalSchedule;
+    signalSchedule = nullptr;
+    delete routes;
+    routes = nullptr;
     return true;
 }
 
@@ -55,18 +120,24 @@ bool WeightedDigraph::removeRoadSegment(int id) {
     if (idToRoadSegment.count(id) == 0) return false;
     RoadSegment *r = idToRoadSegment[id];
     Intersection *source = r->getSource(), *destination = r->getDestination();
+    // only a road segment within a component can split it
+    if (source->getComponent() == destination->getComponent()) componentsChanged = true;
+    reachableChanged = true;
     source->remove(r);
     if (source->outdegree() == 0 && source->indegree() == 0) {
         idToIntersection.erase(source->getID());
         intersections--;
+        if (source->isMarked()) markedIntersections.erase(find(markedIntersections.begin(), markedIntersections.end(), source));
         delete source;
     }
     r->getDestination()->remove(r);
     if (destination->outdegree() == 0 && destination->indegree() == 0) {
         idToIntersection.erase(destination->getID());
         intersections--;
+        if (destination->isMarked()) markedIntersections.erase(find(markedIntersections.begin(), markedIntersections.end(), destination));
         delete destination;
     }
+    if (r->getActiveIndex() >= 0) deactivate(r);
     idToRoadSegment.erase(id);
     if (roadSegmentIDs.size() > 1) {
         roadSegmentIDs[compressedIndex[id]] = roadSegmentIDs.back();
@@ -75,6 +146,22 @@ bool WeightedDigraph::removeRoadSegment(int id) {
     compressedIndex.erase(id);
     roadSegmentIDs.pop_back();
     roadSegments--;
+    delete compiled;
+    compiled = nullptr;
+    delete landmarks;
+    landmarks = nullptr;
+    delete hierarchy;
+    hierarchy = nullptr;
+    delete routingTables;
+    routingTables = nullptr;
+    delete travelTimes;
+    travelTimes = nullptr;
+    delete movementGraph;
+    movementGraph = nullptr;
+    delete signalSchedule;
+    signalSchedule = nullptr;
+    delete routes;
+    routes = nullptr;
     return true;
 }
 
@@ -148,7 +235,355 @@ int WeightedDigraph::getCompressedIndex(int id) {
     return compressedIndex[id];
 }
 
+/**
+ * Returns a pointer to the store of the cars travelling in the graph.
+ */
+CarStore *WeightedDigraph::getCarStore() const { return carStore; }
+
+/**
+ * Returns a pointer to the compressed sparse row form of the graph, building it first if the graph changed.
+ * The pointer is invalidated when a road segment is added or removed.
+ */
+CSRGraph *WeightedDigraph::getCompiled() {
+    if (compiled == nullptr) compiled = new CSRGraph(this);
+    return compiled;
+}
+
+/**
+ * Returns a pointer to the landmarks of the compiled graph, choosing them first if the graph changed.
+ * The pointer is invalidated when a road segment is added or removed.
+ */
+Landmarks *WeightedDigraph::getLandmarks() {
+    if (landmarks == nullptr) landmarks = new Landmarks(getCompiled(), LANDMARKS);
+    return landmarks;
+}
+
+/**
+ * Returns a pointer to the contraction hierarchy of the compiled graph, building it first if the graph changed.
+ * The hierarchy is built on the threads given to setPool(). The pointer is invalidated when a road segment is added or
+ * removed.
+ */
+ContractionHierarchy *WeightedDigraph::getHierarchy() {
+    if (hierarchy == nullptr && pool == nullptr) {
+        ThreadPool serial(1);
+        hierarchy = new ContractionHierarchy(getCompiled(), &serial);
+    } else if (hierarchy == nullptr) {
+        hierarchy = new ContractionHierarchy(getCompiled(), pool);
+    }
+    return hierarchy;
+}
+
+/**
+ * Returns a pointer to the cache of routing tables of the compiled graph, making an empty one first if the graph
+ * changed. The pointer is invalidated when a road segment is added or removed, and tables held by cars are then stale.
+ */
+RoutingTableCache *WeightedDigraph::getRoutingTables() {
+    if (routingTables == nullptr) routingTables = new RoutingTableCache(getCompiled(), getTravelTimes(), ROUTING_TABLE_BUDGET);
+    return routingTables;
+}
+
+/**
+ * Returns a pointer to the live travel times of the compiled graph, starting them at free flow first if the graph
+ * changed. The pointer is invalidated when a road segment is added or removed.
+ */
+TravelTimes *WeightedDigraph::getTravelTimes() {
+    if (travelTimes == nullptr) travelTimes = new TravelTimes(getCompiled());
+    return travelTimes;
+}
+
+/**
+ * Returns a pointer to the movement graph of the compiled graph, building it first if the graph changed.
+ * The pointer is invalidated when a road segment is added or removed.
+ */
+MovementGraph *WeightedDigraph::getMovementGraph() {
+    if (movementGraph == nullptr) movementGraph = new MovementGraph(getCompiled(), turnPenalty);
+    return movementGraph;
+}
+
+/**
+ * Returns the penalty of a type of movement in the movement graph, in seconds.
+ * @param type LEFT, STRAIGHT, RIGHT or UTURN
+ */
+double WeightedDigraph::getTurnPenalty(int type) const {
+    assert(type >= 0 && type < (int) turnPenalty.size() && "type is not valid");
+    return turnPenalty[type];
+}
+
+/**
+ * Sets the penalty of a type of movement in the movement graph, such as the expected wait at its traffic light.
+ * @param type LEFT, STRAIGHT, RIGHT or UTURN
+ * @param penalty the penalty in seconds (must be a non-negative value)
+ */
+void WeightedDigraph::setTurnPenalty(int type, double penalty) {
+    assert(type >= 0 && type < (int) turnPenalty.size() && "type is not valid");
+    assert(penalty >= 0.0 && "penalty must be a non-negative value");
+    turnPenalty[type] = penalty;
+    if (movementGraph != nullptr) movementGraph->setPenalty(type, penalty);
+}
+
+/**
+ * Returns a pointer to the schedule of the traffic lights under pretimed control, building it first if the graph
+ * changed. Every intersection is taken to cycle first at time 0, as the drivers start them.
+ * The pointer is invalidated when a road segment is added or removed.
+ */
+SignalSchedule *WeightedDigraph::getSignalSchedule() {
+    if (signalSchedule == nullptr) signalSchedule = new SignalSchedule(getCompiled(), getMovementGraph(), LEFT_PHASE_TIME, STRAIGHT_PHASE_TIME, 0.0);
+    return signalSchedule;
+}
+
+/**
+ * Returns a pointer to the store that interns the routes of cars on the compiled graph, creating it if needed.
+ * The pointer is invalidated when a road segment is added or removed, and so are the routes it handed out, since
+ * they are indexed by the compiled graph.
+ */
+RouteStore *WeightedDigraph::getRoutes() {
+    if (routes == nullptr) routes = new RouteStore(getCompiled());
+    return routes;
+}
+
+/**
+ * Returns whether an intersection can be reached from another, which is the case when both are in the same strongly
+ * connected component, or when the component of the destination can be reached from the component of the source over
+ * the one-way road segments between components. The reachable components are found again first if a road segment
+ * was added or removed, and the check is otherwise constant time. Graphs with more than REACHABLE_MAX_COMPONENTS
+ * components are searched instead, only visiting components that can still lead to the destination.
+ * @param from the intersection the trip starts at
+ * @param to the intersection the trip ends at
+ */
+bool WeightedDigraph::isReachable(Intersection *from, Intersection *to) {
+    if (reachableChanged) findReachable();
+    int a = from->getComponent(), b = to->getComponent();
+    if (a == b) return true;
+    if (b > a) return false; // components only reach components labelled before them
+    if (!reachable.empty()) return (reachable[(size_t) a * reachableWords + b / 64] >> (b % 64)) & 1;
+    CSRGraph *C = getCompiled();
+    const vector<int> &outStart = C->getOutStart(), &outRoads = C->getOutRoads(), &destination = C->getDestinations();
+    vector<char> visited(C->countIntersections(), false);
+    vector<int> stk(1, from->getIndex());
+    visited[from->getIndex()] = true;
+    while (!stk.empty()) {
+        int v = stk.back();
+        stk.pop_back();
+        if (C->getIntersection(v)->getComponent() == b) return true;
+        for (int e = outStart[v]; e < outStart[v + 1]; e++) {
+            int w = destination[outRoads[e]];
+            if (visited[w] || C->getIntersection(w)->getComponent() < b) continue;
+            visited[w] = true;
+            stk.push_back(w);
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns the number of strongly connected components.
+ */
+int WeightedDigraph::countComponents() {
+    if (componentsChanged) labelComponents();
+    vector<int> labels;
+    for (pair<int, Intersection*> n : idToIntersection) {
+        labels.push_back(n.second->getComponent());
+    }
+    sort(labels.begin(), labels.end());
+    return unique(labels.begin(), labels.end()) - labels.begin();
+}
+
+/**
+ * Labels the strongly connected components with Tarjan's algorithm over the compiled graph. The recursion is kept on
+ * an explicit stack, so long chains of intersections do not overflow the call stack. A component is labelled after
+ * every component it reaches, so road segments between components always lead to a smaller label.
+ */
+void WeightedDigraph::labelComponents() {
+    CSRGraph *C = getCompiled();
+    const vector<int> &outStart = C->getOutStart(), &outRoads = C->getOutRoads(), &destination = C->getDestinations();
+    int n = C->countIntersections(), counter = 0;
+    vector<int> order(n, -1); // the order each intersection was first visited in, -1 if it was not visited
+    vector<int> low(n); // the earliest visited intersection reachable from the subtree of each intersection
+    vector<int> next(n); // the next outbound road segment to follow from each intersection
+    vector<char> onStack(n, false);
+    vector<int> stk, call;
+    components = 0;
+    for (int root = 0; root < n; root++) {
+        if (order[root] != -1) continue;
+        call.push_back(root);
+        while (!call.empty()) {
+            int v = call.back();
+            if (order[v] == -1) {
+                order[v] = low[v] = counter++;
+                next[v] = outStart[v];
+                stk.push_back(v);
+                onStack[v] = true;
+            }
+            if (next[v] < outStart[v + 1]) {
+                int w = destination[outRoads[next[v]++]];
+                if (order[w] == -1) call.push_back(w);
+                else if (onStack[w]) low[v] = min(low[v], order[w]);
+                continue;
+            }
+            call.pop_back();
+            if (!call.empty()) low[call.back()] = min(low[call.back()], low[v]);
+            if (low[v] == order[v]) {
+                int w;
+                do {
+                    w = stk.back();
+                    stk.pop_back();
+                    onStack[w] = false;
+                    C->getIntersection(w)->setComponent(components);
+                } while (w != v);
+                components++;
+            }
+        }
+    }
+    componentsChanged = false;
+}
+
+/**
+ * Finds the components reachable from each component over the condensation of the graph, which is acyclic. The
+ * components are labelled again so that each one only reaches smaller labels, and are then visited in order of label,
+ * each one reaching itself and everything the components at the end of its outbound road segments reach.
+ * Nothing is kept if there are more than REACHABLE_MAX_COMPONENTS components, since the bitsets grow quadratically.
+ */
+void WeightedDigraph::findReachable() {
+    labelComponents();
+    reachableChanged = false;
+    reachable.clear();
+    reachableWords = (components + 63) / 64;
+    if (components > REACHABLE_MAX_COMPONENTS) return;
+    CSRGraph *C = getCompiled();
+    const vector<int> &outStart = C->getOutStart(), &outRoads = C->getOutRoads(), &destination = C->getDestinations();
+    int n = C->countIntersections();
+    vector<int> memberStart(components + 1, 0), members(n); // the intersections of component c are members[memberStart[c]..memberStart[c + 1])
+    for (int v = 0; v < n; v++) {
+        memberStart[C->getIntersection(v)->getComponent() + 1]++;
+    }
+    for (int c = 0; c < components; c++) {
+        memberStart[c + 1] += memberStart[c];
+    }
+    vector<int> fill(memberStart.begin(), memberStart.end() - 1);
+    for (int v = 0; v < n; v++) {
+        members[fill[C->getIntersection(v)->getComponent()]++] = v;
+    }
+    reachable.assign((size_t) components * reachableWords, 0);
+    for (int c = 0; c < components; c++) {
+        unsigned long long *row = &reachable[(size_t) c * reachableWords];
+        row[c / 64] |= 1ULL << (c % 64);
+        for (int i = memberStart[c]; i < memberStart[c + 1]; i++) {
+            int v = members[i];
+            for (int e = outStart[v]; e < outStart[v + 1]; e++) {
+                int d = C->getIntersection(destination[outRoads[e]])->getComponent();
+                if (d == c) continue;
+                const unsigned long long *next = &reachable[(size_t) d * reachableWords];
+                for (int w = 0; w < reachableWords; w++) {
+                    row[w] |= next[w];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Returns the algorithm used to find the routes of cars.
+ */
+int WeightedDigraph::getRoutingMode() const { return routingMode; }
+
+/**
+ * Sets the algorithm used to find the routes of cars. Every algorithm but ROUTING_LIVE finds a shortest route at the
+ * speed limits, but routes that tie may differ between algorithms. With ROUTING_LIVE, routes follow the live travel
+ * times and change while the cars drive, as the simulation refreshes the routing tables. With ROUTING_TURNS, routes
+ * only take the turns the intersections allow and pay the penalty of each turn. With ROUTING_SIGNALS, routes take
+ * the allowed turns and wait for the known schedule of the pretimed traffic lights instead of a penalty.
+ * @param routingMode ROUTING_DIJKSTRA, ROUTING_ALT, ROUTING_CH, ROUTING_TABLES, ROUTING_LIVE, ROUTING_TURNS or
+ * ROUTING_SIGNALS
+ */
+void WeightedDigraph::setRoutingMode(int routingMode) {
+    assert(routingMode >= ROUTING_DIJKSTRA && routingMode <= ROUTING_SIGNALS && "routingMode is not valid");
+    this->routingMode = routingMode;
+}
+
+/**
+ * Sets the threads that build the lazily built structures of the graph. The pool is not owned by the graph and must
+ * outlive any call that builds them.
+ * @param pool the threads of the simulation, or nullptr to build on the calling thread
+ */
+void WeightedDigraph::setPool(ThreadPool *pool) { this->pool = pool; }
+
+/**
+ * Returns an immutable reference to the road segments with cars on them or scheduled to be on them.
+ * The order only depends on the order the road segments became active and idle.
+ */
+const vector<RoadSegment*> &WeightedDigraph::getActiveRoadSegments() const { return activeRoads; }
+
+/**
+ * Adds a road segment to the active road segments.
+ * @param r the road segment (must be idle)
+ */
+void WeightedDigraph::activate(RoadSegment *r) {
+    assert(r->getActiveIndex() < 0 && "the road segment is already active");
+    r->setActiveIndex(activeRoads.size());
+    activeRoads.push_back(r);
+}
+
+/**
+ * Removes a road segment from the active road segments by moving the last active road segment into its place.
+ * @param r the road segment (must be active)
+ */
+void WeightedDigraph::deactivate(RoadSegment *r) {
+    int index = r->getActiveIndex();
+    assert(index >= 0 && activeRoads[index] == r && "the road segment is not active");
+    activeRoads[index] = activeRoads.back();
+    activeRoads[index]->setActiveIndex(index);
+    activeRoads.pop_back();
+    r->setActiveIndex(-1);
+}
+
 /**
  * Returns the efficiency of the city.
  */
-double WeightedDigraph::getEfficiency() { return Car::getEfficiency(); }
+double WeightedDigraph::getEfficiency() { return context->getEfficiency(); }
+
+/**
+ * Returns the context that owns the graph.
+ */
+SimulationContext *WeightedDigraph::getContext() const { return context; }
+
+/**
+ * Returns a reference to the road segments whose waiting queues were woken since the list was last cleared.
+ * The simulation clears the list once it has reacted to the wake-ups.
+ */
+vector<RoadSegment*> &WeightedDigraph::getWokenRoadSegments() { return wokenRoads; }
+
+/**
+ * Adds an intersection to the marked intersections unless it is already marked.
+ * @param n the intersection
+ */
+void WeightedDigraph::markIntersection(Intersection *n) {
+    if (n->isMarked()) return;
+    n->setMarked(true);
+    markedIntersections.push_back(n);
+}
+
+/**
+ * Returns a reference to the intersections whose demand changed or that were marked since the list was last cleared.
+ * The controller clears the list once it has checked them, and must unmark each intersection it takes out.
+ */
+vector<Intersection*> &WeightedDigraph::getMarkedIntersections() { return markedIntersections; }
+
+/**
+ * Returns the seed of every random stream in the run.
+ */
+unsigned long long WeightedDigraph::getSeed() const { return seed; }
+
+/**
+ * Sets the seed of every random stream in the run and restarts the stream that places new cars.
+ * A run is reproduced by the seed alone, regardless of the number of threads.
+ * @param seed the seed
+ */
+void WeightedDigraph::setSeed(unsigned long long seed) {
+    this->seed = seed;
+    spawnRandom = RandomStream(seed, STREAM_SPAWN);
+}
+
+/**
+ * Returns a reference to the random stream that places new cars.
+ */
+RandomStream &WeightedDigraph::getSpawnRandom() { return spawnRandom; }
@@ -6,18 +6,64 @@
 #include "Forward.h"
 #include "RoadSegment.h"
 #include "Intersection.h"
+#include "CarStore.h"
+#include "CSRGraph.h"
+#include "Landmarks.h"
+#include "ContractionHierarchy.h"
+#include "RoutingTableCache.h"
+#include "TravelTimes.h"
+#include "MovementGraph.h"
+#include "SignalSchedule.h"
+#include "RouteStore.h"
+#include "../misc/Random.h"
+
+#define ROUTING_DIJKSTRA 0 // routes are found by Dijkstra's algorithm
+#define ROUTING_ALT 1 // routes are found by A* with landmarks and the triangle inequality
+#define ROUTING_CH 2 // routes are found in a contraction hierarchy
+#define ROUTING_TABLES 3 // cars follow the shared routing table of their destination
+#define ROUTING_LIVE 4 // cars follow routing tables that are kept up to date with the live travel times
+#define ROUTING_TURNS 5 // routes are found by Dijkstra's algorithm over the movements allowed at each intersection
+#define ROUTING_SIGNALS 6 // routes arrive earliest given the schedule of pretimed traffic lights
+
+#define REACHABLE_MAX_COMPONENTS 8192 // the most components whose reachability is kept in bitsets, more are searched instead
 
 struct WeightedDigraph {
 private:
+    SimulationContext *context; // the context the graph belongs to
     int intersections; // number of intersections
     int roadSegments; // number of road segments
     std::unordered_map<int, Intersection*> idToIntersection; // maps the intersection id numbers to the intersection
     std::unordered_map<int, RoadSegment*> idToRoadSegment; // maps the road segment id numbers to the road segment
     std::vector<int> roadSegmentIDs; // compresses the road segment id numbers to a continuous indexed vector
     std::unordered_map<int, int> compressedIndex; // maps the road segment id to its compressed index
+    CarStore *carStore; // the cars travelling in the graph
+    CSRGraph *compiled; // the compressed sparse row form of the graph, nullptr if the graph changed since it was built
+    Landmarks *landmarks; // the landmarks of the compiled graph, nullptr if they have not been chosen
+    ContractionHierarchy *hierarchy; // the contraction hierarchy of the compiled graph, nullptr if it has not been built
+    RoutingTableCache *routingTables; // the routing tables of the compiled graph, nullptr if none were asked for
+    TravelTimes *travelTimes; // the live travel times of the compiled graph, nullptr if they were not asked for
+    MovementGraph *movementGraph; // the movement graph of the compiled graph, nullptr if it has not been built
+    std::vector<double> turnPenalty; // the penalty of each type of movement in the movement graph
+    SignalSchedule *signalSchedule; // the pretimed signal schedule of the movement graph, nullptr if it has not been built
+    RouteStore *routes; // the interned routes of cars on the compiled graph, nullptr if none were asked for
+    int routingMode; // the algorithm used to find the routes of cars
+    ThreadPool *pool; // the threads that build the lazily built structures, nullptr to build them on the calling thread
+    int components; // the number of component labels given out, which is at least the number of strongly connected components
+    bool componentsChanged; // whether a road segment was added or removed that may merge or split the components
+    std::vector<unsigned long long> reachable; // the components reachable from each component as bitsets, empty if there are too many components
+    int reachableWords; // the number of 64-bit words in the bitset of each component
+    bool reachableChanged; // whether a road segment was added or removed since the reachable components were found
+    std::vector<RoadSegment*> activeRoads; // the road segments with cars on them or scheduled to be on them
+    std::vector<RoadSegment*> wokenRoads; // the road segments whose queues were woken since the list was last cleared
+    std::vector<Intersection*> markedIntersections; // the intersections whose demand changed or that were marked since the list was last cleared
+    unsigned long long seed; // the seed of every random stream in the run
+    RandomStream spawnRandom; // the random stream that places new cars
+
+    void labelComponents();
+    void findReachable();
 
 public:
-    WeightedDigraph();
+    WeightedDigraph(SimulationContext *context);
     ~WeightedDigraph();
     int countIntersections() const;
     int countRoadSegments() const;
@@ -33,7 +79,33 @@ public:
     int getRoadSegmentID(int index);
     const std::unordered_map<int, int> &getCompressedIndices() const;
     int getCompressedIndex(int id);
+    CarStore *getCarStore() const;
+    CSRGraph *getCompiled();
+    Landmarks *getLandmarks();
+    ContractionHierarchy *getHierarchy();
+    RoutingTableCache *getRoutingTables();
+    TravelTimes *getTravelTimes();
+    MovementGraph *getMovementGraph();
+    double getTurnPenalty(int type) const;
+    void setTurnPenalty(int type, double penalty);
+    SignalSchedule *getSignalSchedule();
+    RouteStore *getRoutes();
+    int getRoutingMode() const;
+    bool isReachable(Intersection *from, Intersection *to);
+    int countComponents();
+    void setRoutingMode(int routingMode);
+    void setPool(ThreadPool *pool);
+    const std::vector<RoadSegment*> &getActiveRoadSegments() const;
+    void activate(RoadSegment *r);
+    void deactivate(RoadSegment *r);
+    std::vector<RoadSegment*> &getWokenRoadSegments();
+    void markIntersection(Intersection *n);
+    std::vector<Intersection*> &getMarkedIntersections();
     double getEfficiency();
+    SimulationContext *getContext() const;
+    unsigned long long getSeed() const;
+    void setSeed(unsigned long long seed);
+    RandomStream &getSpawnRandom();
 };
 
 #endif
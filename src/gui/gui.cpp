@@ -87,7 +87,8 @@ void GUI::drawComponents() {
     double labelPosX;
     double labelPosY;
     double percentage;
-    Car *car;
+    Point2D carLocation;
+    CarStore *store = graph->getCarStore();
 
     // draws circles to represent each intersection
     for(pair<int, Intersection*> p: graph->getIntersections()) {
@@ -126,9 +127,9 @@ void GUI::drawComponents() {
         painter.drawLine(source, destination);
 
         // draws blue dots to represent cars
-        for (pair<int, Car*> c : road->getCars()) {
-            car = c.second;
-            QPoint location(car->getCurrentLocation().x * SCALE_FACTOR + adjX, car->getCurrentLocation().y * SCALE_FACTOR + adjY);
+        for (int i = 0; i < road->getFlow(); i++) {
+            carLocation = road->getLocationAt(store->getPositions()[road->getCarAt(i).index]); // world coordinates are only needed here
+            QPoint location(carLocation.x * SCALE_FACTOR + adjX, carLocation.y * SCALE_FACTOR + adjY);
             painter.setPen(QPen(QColor(COLOR_BLUE.r, COLOR_BLUE.g, COLOR_BLUE.b))); // border colour is changed here
             painter.setBrush(QBrush(QColor(COLOR_BLUE.r, COLOR_BLUE.g, COLOR_BLUE.b))); // fill colour is changed here
             painter.drawEllipse(location, CAR_RADIUS, CAR_RADIUS); // change the constant to change the radius, DO NOT change this value here
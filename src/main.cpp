@@ -1,14 +1,15 @@
 #include <string>
 #include <cstdio>
-#include <ctime>
 #include "GUIDriver.h"
+#include "HeadlessDriver.h"
 
 using namespace std;
 
 int main(int argc, char *argv[]) {
-    srand(time(NULL));
     GUIDriver *gd = new GUIDriver(argc, argv, 20, ":/data/diagonalGridDemo.txt", 1);
     // GUIDriver *gd = new GUIDriver(argc, argv, 20, ":/data/gridDemo.txt", 1);
     gd->run();
+    // HeadlessDriver *hd = new HeadlessDriver(0.05, "data/diagonalGridDemo.txt", 1); // runs one simulated hour as fast as possible
+    // hd->run(3600.0, -1);
     return 0;
 }
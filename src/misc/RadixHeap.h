@@ -0,0 +1,105 @@
+#ifndef RADIXHEAP_H
+#define RADIXHEAP_H
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <assert.h>
+
+/**
+ * A monotone priority queue of (key, value) pairs with non-negative double keys. Non-negative doubles order the same
+ * way as their bit patterns, so the keys are bucketed by the highest bit in which they differ from the last key
+ * removed. Each pair moves to a lower bucket at most 64 times, and no comparisons between pairs are needed.
+ * A key pushed must not be smaller than the last key removed, which holds for Dijkstra's algorithm.
+ */
+struct RadixHeap {
+private:
+    std::vector<std::pair<uint64_t, int>> buckets[65]; // bucket i holds the keys that first differ from last in bit i - 1
+    uint64_t last; // the bit pattern of the last key removed
+    int count; // the number of pairs in the heap
+
+    static uint64_t toBits(double key) {
+        uint64_t bits;
+        memcpy(&bits, &key, sizeof(bits));
+        return bits;
+    }
+
+    static double fromBits(uint64_t bits) {
+        double key;
+        memcpy(&key, &bits, sizeof(key));
+        return key;
+    }
+
+    static int bucketOf(uint64_t bits, uint64_t last) {
+        return bits == last ? 0 : 64 - __builtin_clzll(bits ^ last);
+    }
+
+public:
+    /**
+     * Initializes an empty heap.
+     */
+    RadixHeap() : last(0), count(0) {}
+
+    /**
+     * Returns true if the heap is empty, false otherwise.
+     */
+    bool empty() const { return count == 0; }
+
+    /**
+     * Returns the number of pairs in the heap.
+     */
+    int size() const { return count; }
+
+    /**
+     * Removes every pair and allows any non-negative key to be pushed again. The buckets keep their memory.
+     */
+    void clear() {
+        for (std::vector<std::pair<uint64_t, int>> &b : buckets) b.clear();
+        last = 0;
+        count = 0;
+    }
+
+    /**
+     * Adds a pair to the heap.
+     * @param key the key (must be non-negative and not smaller than the last key removed)
+     * @param value the value
+     */
+    void push(double key, int value) {
+        uint64_t bits = toBits(key);
+        assert(key >= 0.0 && bits >= last && "the keys of a radix heap must be monotone");
+        buckets[bucketOf(bits, last)].push_back(std::make_pair(bits, value));
+        count++;
+    }
+
+    /**
+     * Removes and returns the pair with the smallest key, and the smallest value among pairs with that key.
+     */
+    std::pair<double, int> pop() {
+        assert(count > 0 && "the heap is empty");
+        if (buckets[0].empty()) { // redistributes the lowest non-empty bucket around its smallest key
+            int i = 1;
+            while (buckets[i].empty()) i++;
+            uint64_t smallest = buckets[i][0].first;
+            for (std::pair<uint64_t, int> &p : buckets[i]) {
+                if (p.first < smallest) smallest = p.first;
+            }
+            last = smallest;
+            for (std::pair<uint64_t, int> &p : buckets[i]) {
+                buckets[bucketOf(p.first, last)].push_back(p);
+            }
+            buckets[i].clear();
+        }
+        int first = 0; // ties are broken by the smallest value, like a binary heap of (key, value) pairs
+        for (int j = 1; j < (int) buckets[0].size(); j++) {
+            if (buckets[0][j].second < buckets[0][first].second) first = j;
+        }
+        std::pair<uint64_t, int> p = buckets[0][first];
+        buckets[0][first] = buckets[0].back();
+        buckets[0].pop_back();
+        count--;
+        return std::make_pair(fromBits(p.first), p.second);
+    }
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <cmath>
+
+// the purposes of the random streams, so streams keyed by the same id never overlap
+#define STREAM_SPAWN 0 // the sources and destinations of new cars
+#define STREAM_SPEED 1 // the speed of a car on each road it enters
+
+/**
+ * A counter-based random number generator (Philox4x32-10). The output is a pure function of a 128-bit counter and
+ * a 64-bit key, so there is no state to share between threads, and any draw can be reproduced from the run seed and
+ * the counter alone.
+ */
+struct Philox {
+    /**
+     * Encrypts a counter with a key.
+     * @param counter the counter
+     * @param key the key (the run seed)
+     * @param out the four random words
+     */
+    static void generate(const uint32_t counter[4], uint64_t key, uint32_t out[4]) {
+        uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        uint32_t k0 = (uint32_t) key, k1 = (uint32_t) (key >> 32);
+        for (int round = 0; round < 10; round++) {
+            uint64_t p0 = (uint64_t) 0xD2511F53u * c0;
+            uint64_t p1 = (uint64_t) 0xCD9E8D57u * c2;
+            uint32_t n0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+            uint32_t n2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+            c0 = n0;
+            c1 = (uint32_t) p1;
+            c2 = n2;
+            c3 = (uint32_t) p0;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+};
+
+/**
+ * A sequence of random numbers identified by the run seed, the purpose of the stream, an id (such as a car ID)
+ * and an event (such as the index of a road on the car's path). Two streams with the same identifiers produce
+ * the same numbers on any thread, so results do not depend on the number of threads or the order they run in.
+ * Creating a stream is free, so a stream can be made on the spot for a single draw.
+ */
+struct RandomStream {
+private:
+    uint64_t seed; // the run seed
+    uint32_t counter[4]; // the purpose, id, event and the index of the next block
+    uint32_t block[4]; // the current block of random words
+    int used; // the number of words of the current block that have been used
+
+public:
+    /**
+     * Initializes a random stream.
+     * @param seed the run seed
+     * @param stream the purpose of the stream
+     * @param id the id of the stream (such as a car ID)
+     * @param event the event of the stream (such as the index of a road on a car's path)
+     */
+    RandomStream(uint64_t seed = 0, uint32_t stream = 0, uint32_t id = 0, uint32_t event = 0) : seed(seed), used(4) {
+        counter[0] = stream;
+        counter[1] = id;
+        counter[2] = event;
+        counter[3] = 0;
+    }
+
+    /**
+     * Returns the next random 32-bit word.
+     */
+    uint32_t next() {
+        if (used == 4) {
+            Philox::generate(counter, seed, block);
+            counter[3]++;
+            used = 0;
+        }
+        return block[used++];
+    }
+
+    /**
+     * Returns a random double in [0, 1).
+     */
+    double nextDouble() {
+        uint64_t hi = next(); // the words are drawn in order, so every compiler gives the same double
+        uint64_t lo = next();
+        uint64_t bits = (hi << 21) ^ (lo >> 11); // 53 random bits
+        return bits * (1.0 / 9007199254740992.0);
+    }
+
+    /**
+     * Returns a random integer in [0, n).
+     * @param n the number of possible values (must be a positive integer)
+     */
+    int nextInt(int n) {
+        return (int) (((uint64_t) next() * (uint64_t) n) >> 32);
+    }
+
+    /**
+     * Returns a normally distributed random double (Box-Muller transform).
+     * @param mean the mean
+     * @param stddev the standard deviation
+     */
+    double nextNormal(double mean, double stddev) {
+        double u = 1.0 - nextDouble(); // in (0, 1], so the log is finite
+        double v = nextDouble();
+        return mean + stddev * sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+    }
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads that run parallel for loops.
+ * The calling thread takes part in every loop, so a pool of size 1 has no workers and runs everything inline.
+ * A loop started from inside a worker runs inline as well, so nested loops cannot deadlock the pool.
+ */
+struct ThreadPool {
+private:
+    std::vector<std::thread> workers; // the worker threads (the calling thread is not included)
+    std::mutex lock; // guards the job fields below
+    std::condition_variable jobReady; // signalled when a new job is posted or the pool is shutting down
+    std::condition_variable jobDone; // signalled when the last worker finishes the current job
+    const std::function<void(int, int)> *job; // the current job, called with a range [begin, end)
+    int jobSize; // the number of indices in the current job
+    int grain; // the number of indices taken at a time
+    std::atomic<int> nextIndex; // the next index that has not been taken
+    int generation; // incremented each time a job is posted
+    int busy; // the number of workers still running the current job
+    bool shutdown; // whether the workers should exit
+
+    static bool &insideWorker() {
+        static thread_local bool inside = false;
+        return inside;
+    }
+
+    /**
+     * Takes ranges of the current job until there are none left.
+     */
+    void drain() {
+        while (true) {
+            int begin = nextIndex.fetch_add(grain);
+            if (begin >= jobSize) return;
+            int end = begin + grain < jobSize ? begin + grain : jobSize;
+            (*job)(begin, end);
+        }
+    }
+
+    /**
+     * The loop run by every worker thread.
+     */
+    void work() {
+        insideWorker() = true;
+        int seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                jobReady.wait(guard, [&] { return shutdown || generation != seen; });
+                if (shutdown) return;
+                seen = generation;
+            }
+            drain();
+            std::lock_guard<std::mutex> guard(lock);
+            if (--busy == 0) jobDone.notify_one();
+        }
+    }
+
+public:
+    /**
+     * Initializes a pool that runs loops on the specified number of threads (including the calling thread).
+     * @param threads the number of threads (must be a positive integer)
+     */
+    ThreadPool(int threads) : job(nullptr), jobSize(0), grain(1), nextIndex(0), generation(0), busy(0), shutdown(false) {
+        for (int i = 1; i < threads; i++) {
+            workers.emplace_back(&ThreadPool::work, this);
+        }
+    }
+
+    /**
+     * Deconstructs the pool and joins the worker threads.
+     */
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            shutdown = true;
+        }
+        jobReady.notify_all();
+        for (std::thread &t : workers) t.join();
+    }
+
+    /**
+     * Returns the number of threads that take part in a loop.
+     */
+    int size() const { return workers.size() + 1; }
+
+    /**
+     * Calls fn on ranges [begin, end) that together cover [0, n) exactly once, and returns when all of them are done.
+     * Ranges are handed out dynamically, so fn must not depend on which thread runs which range.
+     * @param n the number of indices
+     * @param grain the number of indices in each range
+     * @param fn the function to call on each range
+     */
+    void parallelFor(int n, int grain, const std::function<void(int, int)> &fn) {
+        if (n <= 0) return;
+        if (workers.empty() || insideWorker() || n <= grain) {
+            fn(0, n);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            job = &fn;
+            jobSize = n;
+            this->grain = grain;
+            nextIndex = 0;
+            busy = workers.size();
+            generation++;
+        }
+        jobReady.notify_all();
+        drain();
+        std::unique_lock<std::mutex> guard(lock);
+        jobDone.wait(guard, [&] { return busy == 0; });
+        job = nullptr;
+    }
+};
+
+#endif
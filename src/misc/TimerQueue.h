@@ -0,0 +1,195 @@
+#ifndef TIMERQUEUE_H
+#define TIMERQUEUE_H
+
+#include <limits>
+#include <utility>
+#include <vector>
+#include <assert.h>
+
+/**
+ * A queue of timers that holds at most one pending timer for each key, such as the index of an intersection.
+ * The timers are kept in a binary heap ordered by (time, key), and the position of each key in the heap is indexed,
+ * so a timer can be scheduled, moved or cancelled in O(log n) and checked in O(1). Timers that are due at the same
+ * time fire in order of key. The queue counts the operations done on it, so their rates can be reported.
+ */
+struct TimerQueue {
+private:
+    std::vector<std::pair<double, int>> heap; // the pending timers as (time, key) pairs
+    std::vector<int> position; // the position of each key in the heap, -1 if the key has no pending timer
+    int peak; // the most timers that were pending at once
+    long long scheduled; // the number of timers added
+    long long rescheduled; // the number of pending timers that were moved
+    long long cancelled; // the number of pending timers that were removed before they fired
+    long long fired; // the number of timers that were removed when due
+
+    /**
+     * Moves the timer at a position up the heap until its parent is earlier.
+     */
+    void siftUp(int i) {
+        std::pair<double, int> t = heap[i];
+        while (i > 0 && t < heap[(i - 1) / 2]) {
+            heap[i] = heap[(i - 1) / 2];
+            position[heap[i].second] = i;
+            i = (i - 1) / 2;
+        }
+        heap[i] = t;
+        position[t.second] = i;
+    }
+
+    /**
+     * Moves the timer at a position down the heap until its children are later.
+     */
+    void siftDown(int i) {
+        std::pair<double, int> t = heap[i];
+        int n = heap.size();
+        while (2 * i + 1 < n) {
+            int child = 2 * i + 1;
+            if (child + 1 < n && heap[child + 1] < heap[child]) child++;
+            if (!(heap[child] < t)) break;
+            heap[i] = heap[child];
+            position[heap[i].second] = i;
+            i = child;
+        }
+        heap[i] = t;
+        position[t.second] = i;
+    }
+
+    /**
+     * Removes the timer at a position from the heap.
+     */
+    void removeAt(int i) {
+        position[heap[i].second] = -1;
+        std::pair<double, int> last = heap.back();
+        heap.pop_back();
+        if (i == (int) heap.size()) return;
+        heap[i] = last;
+        position[last.second] = i;
+        siftUp(i);
+        siftDown(position[last.second]);
+    }
+
+public:
+    /**
+     * Initializes an empty queue.
+     */
+    TimerQueue() : peak(0), scheduled(0), rescheduled(0), cancelled(0), fired(0) {}
+
+    /**
+     * Returns true if no timers are pending, false otherwise.
+     */
+    bool empty() const { return heap.empty(); }
+
+    /**
+     * Returns the number of pending timers.
+     */
+    int size() const { return heap.size(); }
+
+    /**
+     * Returns true if a key has a pending timer, false otherwise.
+     * @param key the key (must be non-negative)
+     */
+    bool isPending(int key) const { return key < (int) position.size() && position[key] != -1; }
+
+    /**
+     * Returns the time a key's timer is due, or infinity if the key has no pending timer.
+     * @param key the key (must be non-negative)
+     */
+    double getTime(int key) const { return isPending(key) ? heap[position[key]].first : std::numeric_limits<double>::infinity(); }
+
+    /**
+     * Returns the time of the earliest pending timer, or infinity if no timers are pending.
+     */
+    double getNextTime() const { return heap.empty() ? std::numeric_limits<double>::infinity() : heap[0].first; }
+
+    /**
+     * Returns the key of the earliest pending timer.
+     */
+    int getNextKey() const {
+        assert(!heap.empty() && "no timers are pending");
+        return heap[0].second;
+    }
+
+    /**
+     * Sets the timer of a key, replacing its pending timer if it has one.
+     * @param key the key (must be non-negative)
+     * @param time the time the timer is due
+     */
+    void schedule(int key, double time) {
+        assert(key >= 0 && "key must be non-negative");
+        if (key >= (int) position.size()) position.resize(key + 1, -1);
+        if (position[key] != -1) {
+            int i = position[key];
+            heap[i].first = time;
+            siftUp(i);
+            siftDown(position[key]);
+            rescheduled++;
+            return;
+        }
+        heap.push_back(std::make_pair(time, key));
+        siftUp(heap.size() - 1);
+        if ((int) heap.size() > peak) peak = heap.size();
+        scheduled++;
+    }
+
+    /**
+     * Sets the timer of a key unless it already has a timer that is due at or before the time.
+     * @param key the key (must be non-negative)
+     * @param time the time the timer is due
+     * @return true if the timer was set, false otherwise
+     */
+    bool scheduleBefore(int key, double time) {
+        if (getTime(key) <= time) return false;
+        schedule(key, time);
+        return true;
+    }
+
+    /**
+     * Removes the pending timer of a key.
+     * @param key the key (must be non-negative)
+     * @return true if the key had a pending timer, false otherwise
+     */
+    bool cancel(int key) {
+        if (!isPending(key)) return false;
+        removeAt(position[key]);
+        cancelled++;
+        return true;
+    }
+
+    /**
+     * Removes the earliest pending timer and returns its key.
+     */
+    int pop() {
+        assert(!heap.empty() && "no timers are pending");
+        int key = heap[0].second;
+        removeAt(0);
+        fired++;
+        return key;
+    }
+
+    /**
+     * Returns the most timers that were pending at once.
+     */
+    int getPeak() const { return peak; }
+
+    /**
+     * Returns the number of timers added.
+     */
+    long long countScheduled() const { return scheduled; }
+
+    /**
+     * Returns the number of pending timers that were moved to another time.
+     */
+    long long countRescheduled() const { return rescheduled; }
+
+    /**
+     * Returns the number of pending timers that were removed before they fired.
+     */
+    long long countCancelled() const { return cancelled; }
+
+    /**
+     * Returns the number of timers that fired.
+     */
+    long long countFired() const { return fired; }
+};
+
+#endif
@@ -2,6 +2,8 @@ QT       += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+CONFIG += c++14 thread
+
 # TODO: MIGHT NEED TO CHANGE THIS TARGET PATH
 TARGET = framework
 TEMPLATE = app
@@ -22,28 +24,51 @@ SOURCES += \
         main.cpp \
         ConsoleDriver.cpp \
         GUIDriver.cpp \
+        HeadlessDriver.cpp \
         Simulation.cpp \
+        EventSimulation.cpp \
         controller/Controller.cpp \
         controller/PretimedController.cpp \
         controller/BasicController.cpp \
+        controller/MaxPressureController.cpp \
         gui/gui.cpp \
         framework/Car.cpp \
+        framework/CarStore.cpp \
+        framework/CSRGraph.cpp \
+        framework/ContractionHierarchy.cpp \
         framework/DijkstraDirectedSP.cpp \
         framework/Intersection.cpp \
+        framework/Landmarks.cpp \
+        framework/MovementGraph.cpp \
         framework/Point2D.cpp \
+        framework/Route.cpp \
+        framework/RouteStore.cpp \
+        framework/RoutingTable.cpp \
+        framework/RoutingTableCache.cpp \
+        framework/RoutingWorkspace.cpp \
         framework/RoadSegment.cpp \
+        framework/SignalSchedule.cpp \
+        framework/SimulationContext.cpp \
         framework/TrafficLight.cpp \
+        framework/TravelTimes.cpp \
         framework/WeightedDigraph.cpp
 
 HEADERS += \
         ConsoleDriver.h \
         GUIDriver.h \
+        HeadlessDriver.h \
         Simulation.h \
+        EventSimulation.h \
         gui/gui.h \
         controller/Controller.h \
         controller/PretimedController.h \
         controller/BasicController.h \
+        controller/MaxPressureController.h \
         misc/pair_hash.h \
+        misc/ThreadPool.h \
+        misc/Random.h \
+        misc/RadixHeap.h \
+        misc/TimerQueue.h \
         framework/Framework.h
 
 FORMS += \